@@ -9,5 +9,7 @@ public class Leviathan : ModuleRules
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Json", "TraceLog", "Slate", "SlateCore", "AIModule", "NavigationSystem", "UMG" });
 	}
 }
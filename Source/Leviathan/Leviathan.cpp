@@ -1,7 +1,24 @@
 ﻿// Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Leviathan.h"
+#include "LeviathanMemory.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Leviathan, "Leviathan" );
+DEFINE_LOG_CATEGORY(LogLeviathan);
+
+class FLeviathanModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		FLeviathanMemory::Startup();
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FLeviathanMemory::Shutdown();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FLeviathanModule, Leviathan, "Leviathan" );
  
\ No newline at end of file
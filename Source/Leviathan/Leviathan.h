@@ -3,3 +3,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogLeviathan, Log, All);
+
+//Use "stat Leviathan" to see where the axe and character spend the frame.
+DECLARE_STATS_GROUP(TEXT("Leviathan"), STATGROUP_Leviathan, STATCAT_Advanced);
@@ -0,0 +1,71 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanAimCameraComponent.h"
+
+#include "Leviathan.h"
+#include "LeviathanCharacter.h"
+
+DECLARE_CYCLE_STAT(TEXT("AimCamera Tick"), STAT_AimCameraTick, STATGROUP_Leviathan);
+
+ULeviathanAimCameraComponent::ULeviathanAimCameraComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	//Only ticks while blending.
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+void ULeviathanAimCameraComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	if(bDriveCamera)
+	{
+		ApplyBlend();
+	}
+}
+
+void ULeviathanAimCameraComponent::SetAiming(bool bAim)
+{
+	TargetAlpha = bAim ? 1.f : 0.f;
+	if(bDriveCamera)
+	{
+		SetComponentTickEnabled(true);
+	}
+}
+
+void ULeviathanAimCameraComponent::SnapToTarget()
+{
+	BlendAlpha = TargetAlpha;
+	BlendVelocity = 0.f;
+	ApplyBlend();
+	SetComponentTickEnabled(false);
+}
+
+void ULeviathanAimCameraComponent::TickComponent(float DeltaTime, ELevelTick TickType,
+	FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AimCameraTick);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	//Exact solution of a critically damped spring over DeltaTime, so the blend looks the same at any frame rate.
+	const float Omega = 2.f / BlendSmoothTime;
+	const float Offset = BlendAlpha - TargetAlpha;
+	const float Temp = (BlendVelocity + Omega * Offset) * DeltaTime;
+	const float Decay = FMath::Exp(-Omega * DeltaTime);
+	BlendAlpha = TargetAlpha + (Offset + Temp) * Decay;
+	BlendVelocity = (BlendVelocity - Omega * Temp) * Decay;
+
+	if(FMath::Abs(BlendAlpha - TargetAlpha) < SettleTolerance && FMath::Abs(BlendVelocity) < SettleTolerance)
+	{
+		SnapToTarget();
+		return;
+	}
+	ApplyBlend();
+}
+
+void ULeviathanAimCameraComponent::ApplyBlend() const
+{
+	if(ALeviathanCharacter* Character = Cast<ALeviathanCharacter>(GetOwner()))
+	{
+		Character->ApplyCameraBlend(BlendAlpha);
+	}
+}
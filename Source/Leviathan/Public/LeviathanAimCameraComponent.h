@@ -0,0 +1,59 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+
+#include "LeviathanAimCameraComponent.generated.h"
+
+/**Blends the camera boom between the idle and aim positions of ALeviathanCharacter with a critically damped spring.
+ * Replaces the Blueprint timeline that used to call LerpCameraPosition. The spring keeps its velocity when the target
+ * changes, so releasing aim mid-blend just turns around smoothly, and the component stops ticking once settled.
+ */
+UCLASS(ClassGroup = (Camera), meta = (BlueprintSpawnableComponent))
+class LEVIATHAN_API ULeviathanAimCameraComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	ULeviathanAimCameraComponent();
+
+	//Starts blending towards the aim (true) or idle (false) camera.
+	UFUNCTION(BlueprintCallable, Category = AxeAim)
+	void SetAiming(bool bAim);
+
+	//Jumps to the target straight away, no blend.
+	UFUNCTION(BlueprintCallable, Category = AxeAim)
+	void SnapToTarget();
+
+	//0 is the idle camera, 1 is the aim camera.
+	UFUNCTION(BlueprintPure, Category = AxeAim)
+	float GetBlendAlpha() const { return BlendAlpha; }
+
+	/**When true this component drives the camera and LerpCameraPosition calls from Blueprint are ignored.
+	 * Turn it off to go back to the Blueprint timeline.*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = AxeAim)
+	bool bDriveCamera = true;
+
+	//Roughly the time in seconds to cover most of the blend. Lower is snappier.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = AxeAim, meta = (ClampMin = "0.01"))
+	float BlendSmoothTime = 0.15f;
+
+	//When alpha and its velocity are both under this the blend is done and the component stops ticking.
+	UPROPERTY(EditAnywhere, Category = AxeAim, meta = (ClampMin = "0.0"))
+	float SettleTolerance = 0.001f;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
+		FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	void ApplyBlend() const;
+
+	float BlendAlpha = 0.f;
+	float BlendVelocity = 0.f;
+	float TargetAlpha = 0.f;
+};
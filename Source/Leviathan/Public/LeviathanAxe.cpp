@@ -2,18 +2,58 @@
 
 #include "LeviathanAxe.h"
 
+#include "Leviathan.h"
 #include "DrawDebugHelpers.h"
+#include "LeviathanAxeFlightComponent.h"
 #include "LeviathanCharacter.h"
+#include "LeviathanDestructibleManager.h"
+#include "LeviathanFlightRecorderComponent.h"
+#include "LeviathanImpactMarks.h"
+#include "LeviathanInputHistoryComponent.h"
+#include "LeviathanMemory.h"
+#include "LeviathanPerfBudget.h"
+#include "LeviathanSocketCacheComponent.h"
+#include "LeviathanTelemetry.h"
+#include "LeviathanThrowable.h"
+#include "LeviathanTrace.h"
 #include "Camera/CameraComponent.h"
 #include "Components/SceneComponent.h"
 #include "Components/AudioComponent.h"
+#include "Engine/GameInstance.h"
 #include "Kismet/GameplayStatics.h"
-#include "Kismet/KismetMathLibrary.h"
+
+DECLARE_CYCLE_STAT(TEXT("Axe Throw"), STAT_AxeThrow, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe SpinAxe"), STAT_AxeSpin, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe StopAxeMovement"), STAT_AxeStopAxeMovement, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe TimeoutTrace"), STAT_AxeTimeoutTrace, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe LodgeAxe"), STAT_AxeLodgeAxe, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe SetupWiggleReturn"), STAT_AxeSetupWiggleReturn, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe SetupTimelineReturn"), STAT_AxeSetupTimelineReturn, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe WiggleAxe"), STAT_AxeWiggle, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe ReturnTimelineSpeed"), STAT_AxeReturnTimelineSpeed, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe ChangeGravityAndHit"), STAT_AxeChangeGravityAndHit, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe StartParticleTrail"), STAT_AxeStartParticleTrail, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe UpdateReturnAxePosition"), STAT_AxeUpdateReturnAxePosition, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe PlaySoundAndReturnAxeSpinTimelineRate"), STAT_AxePlaySoundAndReturnAxeSpinTimelineRate,
+	STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe DecreaseNumberOfSpins"), STAT_AxeDecreaseNumberOfSpins, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe Tick"), STAT_AxeTick, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe BeginPlay"), STAT_AxeBeginPlay, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe MoveAxeToStartPosition"), STAT_AxeMoveAxeToStartPosition, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe ProjectAxe"), STAT_AxeProjectAxe, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe CalculateImpactPitchOffset"), STAT_AxeCalculateImpactPitchOffset, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe CalculateImpactLocation"), STAT_AxeCalculateImpactLocation, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe PreventClippingOnReturn"), STAT_AxePreventClippingOnReturn, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Axe HandleLodgeHit"), STAT_AxeHandleLodgeHit, STATGROUP_Leviathan);
+
+//Spin, lodge and return maths of this weapon.
+using FAxeThrowable = FLeviathanAxeThrowable;
 
 // Sets default values
 ALeviathanAxe::ALeviathanAxe()
 
 {
+	LEVIATHAN_LLM_SCOPE(Axe);
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
@@ -37,14 +77,20 @@ ALeviathanAxe::ALeviathanAxe()
 	AxeMesh->SetupAttachment(LodgePoint);
 	//Projectile component for projectile calculations.
 	ProjectileMovement = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("ProjectileMovement"));
+	//Optional fixed step flight.
+	FlightComponent = CreateDefaultSubobject<ULeviathanAxeFlightComponent>(TEXT("FlightComponent"));
+	FlightRecorder = CreateDefaultSubobject<ULeviathanFlightRecorderComponent>(TEXT("FlightRecorder"));
 
 	//Particle System.
-	ThrowParticles = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("ThrowParticles"));
-	ThrowParticles->SetupAttachment(AxeMesh);
-	SwingParticles = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("SwingParticles"));
-	SwingParticles->SetupAttachment(AxeMesh);
-	AxeCatchParticles = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("AxeCatchParticles"));
-	AxeCatchParticles->SetupAttachment(AxeMesh);
+	{
+		LEVIATHAN_LLM_SCOPE(AxeFX);
+		ThrowParticles = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("ThrowParticles"));
+		ThrowParticles->SetupAttachment(AxeMesh);
+		SwingParticles = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("SwingParticles"));
+		SwingParticles->SetupAttachment(AxeMesh);
+		AxeCatchParticles = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("AxeCatchParticles"));
+		AxeCatchParticles->SetupAttachment(AxeMesh);
+	}
 	
 
 #pragma endregion
@@ -56,14 +102,38 @@ ALeviathanAxe::ALeviathanAxe()
 // Called when the game starts or when spawned
 void ALeviathanAxe::BeginPlay()
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeBeginPlay);
+	LEVIATHAN_LLM_SCOPE(Axe);
 	Super::BeginPlay();
 	Player = Cast<ALeviathanCharacter>(GetWorld()->GetFirstPlayerController()->GetCharacter());
+	if(Player)
+	{
+		//The return timeline reads AxeSocket every frame, make sure it reads this frame's pose.
+		AxeSocketIndex = Player->SocketCache->FindSocketIndex(ULeviathanSocketCacheComponent::AxeSocketName);
+		Player->SocketCache->AddReaderActor(this);
+	}
+	//Recording is decided when the game instance starts, so it can't turn on later.
+	const UGameInstance* GameInstance = GetGameInstance();
+	ULeviathanTelemetrySubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<ULeviathanTelemetrySubsystem>()
+		: nullptr;
+	Telemetry = Subsystem && Subsystem->IsRecording() ? Subsystem : nullptr;
+}
+
+void ALeviathanAxe::RecordTelemetry(ELeviathanAxeTraceEvent Type) const
+{
+	if(Telemetry)
+	{
+		Telemetry->RecordAxeEvent(Type, this);
+	}
 }
 
 
 
 void ALeviathanAxe::Throw()
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeThrow);
+	LEVIATHAN_LLM_SCOPE(Axe);
+	LEVIATHAN_PERF_SCOPE(Throw);
 	
 	//Only execute if player was aiming and the axe was not thrown already
 	if(!Player->bAxeThrown)
@@ -73,9 +143,13 @@ void ALeviathanAxe::Throw()
 		this->DetachFromActor(FDetachmentTransformRules(EDetachmentRule::KeepWorld,true));
 		//
 		//Get all Data for maths
-		ThrowCameraRotator = Player->FollowCamera->GetComponentRotation();
-		ThrowDirection = Player->FollowCamera->GetForwardVector();
-		ThrowCameraLocation = Player->FollowCamera->GetComponentLocation();
+		//Use the camera from the moment throw was pressed, the graph usually calls this a frame or more later.
+		if(!Player->InputHistory->ConsumeThrowPose(ThrowCameraLocation, ThrowCameraRotator))
+		{
+			ThrowCameraRotator = Player->FollowCamera->GetComponentRotation();
+			ThrowCameraLocation = Player->FollowCamera->GetComponentLocation();
+		}
+		ThrowDirection = ThrowCameraRotator.Vector();
 		
 		
 		MoveAxeToStartPosition();
@@ -83,40 +157,49 @@ void ALeviathanAxe::Throw()
 		StartSpinAxe();
 		Player->bAxeThrown = true;
 
+		ThrowTimeSeconds = FPlatformTime::Seconds();
+		TRACE_LEVIATHAN_AXE_EVENT(Throw, this, 0.f, 0.f, SurfaceType_Default);
+		RecordTelemetry(ELeviathanAxeTraceEvent::Throw);
+		OnAxeEvent.Broadcast(this, ELeviathanAxeTraceEvent::Throw);
+
 	}
 }
 
 void ALeviathanAxe::SpinAxe(float RotateScalar)
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeSpin);
 		
-	float RotationY = RotateScalar*-360.0f;
-	FRotator newRotator = FRotator(RotationY,0.f,0.f);
-	CenterPoint->SetRelativeRotation(newRotator);
+	CenterPoint->SetRelativeRotation(FAxeThrowable::SpinRotation(RotateScalar));
 			
 }
 
 void ALeviathanAxe::StopAxeMovement()
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeStopAxeMovement);
 	ThrowParticles->EndTrails();
 	StopAxeTracing();
 	ProjectileMovement->Deactivate();
+	FlightComponent->Stop();
 }
 
 void ALeviathanAxe::TimeoutTrace()
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeTimeoutTrace);
 	StopAxeMovement();
 	AxeMesh->SetVisibility(false);
 }
 
 void ALeviathanAxe::LodgeAxe(USoundBase* Sound,USoundBase* Sound2, USoundAttenuation* SoundAttenuation)
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeLodgeAxe);
 	//Play Sound (Arrays cannot be used as function parameters, this is why its like this)
-	
+	{
+		LEVIATHAN_LLM_SCOPE(AxeAudio);
 		UGameplayStatics::SpawnSoundAtLocation(GetWorld(),Sound,ImpactLocation,FRotator(0,0,0),
         1,1,0,SoundAttenuation);
 		UGameplayStatics::SpawnSoundAtLocation(GetWorld(),Sound2,ImpactLocation,FRotator(0,0,0),
         1,1,0,SoundAttenuation);
-	
+	}
 	StopAxeMovement();
 	StopSpinAxe();
 	
@@ -135,41 +218,52 @@ void ALeviathanAxe::LodgeAxe(USoundBase* Sound,USoundBase* Sound2, USoundAttenua
 	SetActorLocation(CalculateImpactLocation());
 	//set the corresponding axe state
 	AxeState = EAxeState::Lodged;
+	//Stays behind after the axe is recalled.
+	ALeviathanImpactMarks::AddMarkFromAxe(*this);
+
+	TRACE_LEVIATHAN_AXE_EVENT(Lodge, this, float((FPlatformTime::Seconds() - ThrowTimeSeconds) * 1000.0),
+		FVector::Dist(ThrowCameraLocation, ImpactLocation), ESurfaceHit);
+	RecordTelemetry(ELeviathanAxeTraceEvent::Lodge);
+	OnAxeEvent.Broadcast(this, ELeviathanAxeTraceEvent::Lodge);
 	
 }
 
 void ALeviathanAxe::SetupWiggleReturn(USoundBase* SoundAsset,USoundAttenuation* SoundAttenuation, ESetupEnum& OutputPin)
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeSetupWiggleReturn);
 	//Player->bAxeRecalled = true;
 	StopAxeTracing();
 	AxeMesh->SetVisibility(true);
+	LEVIATHAN_LLM_SCOPE(AxeAudio);
 	ReturnSound_Ref = UGameplayStatics::SpawnSoundAttached(SoundAsset,AxeMesh,"",FVector(0,0,0),
 		FRotator(0,0,0),EAttachLocation::SnapToTarget,false,
 		0.0f,1.0f,0.0f,SoundAttenuation);
 	
 	//
-	switch (AxeState)
+	//A weapon that doesn't wiggle loose comes straight back from the lodge, like one recalled mid-flight.
+	const bool bReturnStraight = AxeState == EAxeState::Launched
+		|| (AxeState == EAxeState::Lodged && !FAxeThrowable::FReturn::bWiggleWhenLodged);
+	if(bReturnStraight)
 	{
-		case EAxeState::Launched:
-			AxeZ_Offset = 10.f;
+		AxeZ_Offset = FAxeThrowable::FReturn::LaunchedZOffset;
 		//Set to execute this pin
 		OutputPin = ESetupEnum::Launched;
 		AxeState = EAxeState::Returning;
-			break;
-		case EAxeState::Lodged:
-			//Setup output pin for calling wiggle function
-			OutputPin = ESetupEnum::Lodged;
-			break;
-			
+	}
+	else if(AxeState == EAxeState::Lodged)
+	{
+		//Setup output pin for calling wiggle function
+		OutputPin = ESetupEnum::Lodged;
 	}
 	
 }
 
 void ALeviathanAxe::SetupTimelineReturn()
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeSetupTimelineReturn);
 	Player->bAxeRecalled = true;
 	//Get the difference between the Axe and the socket of the player mesh.
-	FVector LocationVector = FVector(GetActorLocation() - Player->GetMesh()->GetSocketLocation(TEXT("AxeSocket")));
+	FVector LocationVector = FVector(GetActorLocation() - Player->SocketCache->GetTransform(AxeSocketIndex).GetLocation());
 	//Clamp the distance so its not too far and convert to a float.
 	float Distance = FMath::Clamp(LocationVector.Size(),0.0f,MaxDistanceCalculation);
 	//Store for calculations later
@@ -182,10 +276,17 @@ void ALeviathanAxe::SetupTimelineReturn()
 	InitialCameraRotator = Player->FollowCamera->GetComponentRotation();
 	//Return Lodge Point rotation to normal for smoothly bringing the axe back
 	LodgePoint->SetRelativeRotation(FRotator(0,0,0));
+
+	RecallTimeSeconds = FPlatformTime::Seconds();
+	TRACE_LEVIATHAN_AXE_EVENT(Recall, this, float((RecallTimeSeconds - ThrowTimeSeconds) * 1000.0), DistanceFromCharacter,
+		ESurfaceHit);
+	RecordTelemetry(ELeviathanAxeTraceEvent::Recall);
+	OnAxeEvent.Broadcast(this, ELeviathanAxeTraceEvent::Recall);
 }
 
 void ALeviathanAxe::WiggleAxe(float Rotation)
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeWiggle);
 	//Get the Rotation of the Lodged Axe
 	FRotator BaseRotator = BaseLodgedRotator;
 	//Change rotation based on the timeline * the value of strength.
@@ -193,8 +294,19 @@ void ALeviathanAxe::WiggleAxe(float Rotation)
 	LodgePoint->SetRelativeRotation(BaseRotator);
 }
 
+FLeviathanAxeFlightModel ALeviathanAxe::GetFlightModel(float GravityZ) const
+{
+	FLeviathanAxeFlightModel Model;
+	Model.GravityZ = GravityZ;
+	Model.ZeroGravityTime = ZeroGravityTime;
+	Model.GravityRampTime = GravityRampTime;
+	Model.MaxGravityScale = MaxGravityScale;
+	return Model;
+}
+
 const float ALeviathanAxe::ReturnTimelineSpeed()
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeReturnTimelineSpeed);
 	float TimelineSpeed = 0.0f;
 	TimelineSpeed = ReturnTimelineIdealDistance*ReturnSpeed;
 	//Get the ratio based on the distance from the character
@@ -207,46 +319,22 @@ const float ALeviathanAxe::ReturnTimelineSpeed()
 
 float ALeviathanAxe::CalculateImpactPitchOffset()
 {
-	float InclinedSurfaceOffset = FMath::FRandRange(-30.0,-55.0);
-	float FlatSurfaceOffset = FMath::FRandRange(-5.0f,-25.0f);
-	FRotator Rotator = UKismetMathLibrary::MakeRotationFromAxes(ImpactNormal,FVector(0),FVector(0));
-
-	//If its flat surface
-	if(Rotator.Pitch > 0.0f)
-	{
-		return FlatSurfaceOffset - Rotator.Pitch;
-	}
-	return InclinedSurfaceOffset - Rotator.Pitch;
-
+	SCOPE_CYCLE_COUNTER(STAT_AxeCalculateImpactPitchOffset);
+	//Steeper into walls than into floors, see FLeviathanBladeLodge.
+	return FAxeThrowable::ImpactPitchOffset(ImpactNormal, FMath::FRand());
 }
 
 FVector ALeviathanAxe::CalculateImpactLocation()
 {
-	FRotator Rotator = UKismetMathLibrary::MakeRotationFromAxes(ImpactNormal,FVector(0,0,0),FVector(0,0,0));
-	//If its flat surface
-	if(Rotator.Pitch > 0.0f)
-	{
-		//Should make sure that the axe blade is facing the object that has impacted with
-		AxeZ_Offset = (((90.f - Rotator.Pitch) / 90.f) *10.f);
-		FVector CalculatedLocation = ImpactLocation + FVector(0,0,AxeZ_Offset);
-		CalculatedLocation += GetActorLocation()-LodgePoint->GetComponentLocation();
-		
-		return CalculatedLocation;
-	}
-
-	//If pitch is not bigger than 0 then set to 0 and calculate
-        AxeZ_Offset = 10.f;
-		FVector CalculatedLocation = ImpactLocation + FVector(0,0,AxeZ_Offset);
-		CalculatedLocation += GetActorLocation()-LodgePoint->GetComponentLocation();
-		
-		return CalculatedLocation;
-	
-	
-	
+	SCOPE_CYCLE_COUNTER(STAT_AxeCalculateImpactLocation);
+	//Should make sure that the axe blade is facing the object that has impacted with
+	AxeZ_Offset = FAxeThrowable::ImpactZOffset(ImpactNormal);
+	return ImpactLocation + FVector(0,0,AxeZ_Offset) + GetActorLocation() - LodgePoint->GetComponentLocation();
 }
 
 void ALeviathanAxe::PreventClippingOnReturn()
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxePreventClippingOnReturn);
 	//Rise the axe byt AxeZReturnOffset.
 	FVector AdjustedLocation = GetActorLocation();
 	AdjustedLocation.Z += AxeZReturnOffset;
@@ -255,18 +343,47 @@ void ALeviathanAxe::PreventClippingOnReturn()
 
 bool ALeviathanAxe::ChangeGravityAndHit(float gravity)
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeChangeGravityAndHit);
+	LEVIATHAN_PERF_SCOPE(ChangeGravityAndHit);
 
 	
+	//The fixed step flight does its own gravity and trace, only pass on the lodge it found.
+	if(FlightComponent->bUseFixedStepFlight)
+	{
+		return FlightComponent->ConsumeLodge();
+	}
 	ProjectileMovement->ProjectileGravityScale = gravity;
 	
-	FVector Start = GetActorLocation()+FVector(0,0,41);
-	FVector End = GetActorLocation()+FVector(0,0,41) + (GetActorRotation().Vector() * AxeTraceDistance);
-	GetWorld()->LineTraceSingleByChannel(HitResult,Start,End,ECC_Visibility);
+	FVector Start = GetActorLocation()+FVector(0,0,AxeTraceZOffset);
+	FVector End = Start + (GetActorRotation().Vector() * AxeTraceDistance);
+	{
+		LEVIATHAN_LLM_SCOPE(AxeTraces);
+		GetWorld()->LineTraceSingleByChannel(HitResult,Start,End,ECC_Visibility,GetLodgeQueryParams());
+	}
 
 	// DrawDebugLine(GetWorld(),Start, End,FColor(255, 0, 0),false,
  //        7, 0,5);
 
 	
+	return HandleLodgeHit(ProjectileMovement->Velocity);
+}
+
+FCollisionQueryParams ALeviathanAxe::GetLodgeQueryParams() const
+{
+	//Both flight paths lodge with these, so they hit the same surfaces.
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(LeviathanAxeLodge), false, this);
+	Params.bReturnPhysicalMaterial = true;
+	return Params;
+}
+
+bool ALeviathanAxe::HandleLodgeHit(const FVector& Velocity)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AxeHandleLodgeHit);
+	//Breakable props shatter and let the axe fly through.
+	if(HitResult.bBlockingHit && ALeviathanDestructibleManager::TryBreakFromHit(HitResult, Velocity))
+	{
+		return false;
+	}
 	if(HitResult.bBlockingHit)
 	{
 		ImpactLocation = HitResult.ImpactPoint;
@@ -280,6 +397,8 @@ bool ALeviathanAxe::ChangeGravityAndHit(float gravity)
 
 void ALeviathanAxe::StartParticleTrail()
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeStartParticleTrail);
+	LEVIATHAN_LLM_SCOPE(AxeFX);
 	ThrowParticles->BeginTrails(TEXT("BaseSocket"),TEXT("TipSocket"),
 		ETrailWidthMode_FromCentre,1.0);
 	//At this stage the Axe is finished wiggling and is returning
@@ -289,21 +408,21 @@ void ALeviathanAxe::StartParticleTrail()
 void ALeviathanAxe::UpdateReturnAxePosition(float InitialAlphaRotation, float CloseAlphaRotation, float AxeCurvature,
 	float Speed,float Volume)
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeUpdateReturnAxePosition);
+	LEVIATHAN_PERF_SCOPE(UpdateReturnAxePosition);
 	//Adjusts the curve based on distance from the character and a parameter to scale the curvature
 	//Lower number = more curve
-	float CurveLocation = (DistanceFromCharacter/AxeReturnCurveScalar)*AxeCurvature;
-	//Get the vector to the right of the axe to apply the curvature
-	FVector RightVector = Player->FollowCamera->GetRightVector()*CurveLocation;
-	//Add the right Vector based on the location of the Axe Socket. This is why we use the Curve Timeline
+	const FTransform& AxeSocketTransform = Player->SocketCache->GetTransform(AxeSocketIndex);
+	//The curve is pushed to the right of the camera from the Axe Socket. This is why we use the Curve Timeline
 	//This creates the curve by sending bigger and smaller multipliers
-	FVector CalculatedCurveAxeLocation = Player->GetMesh()->GetSocketLocation(TEXT("AxeSocket"))+ RightVector;
 	//Smoothly interpolate between the 2 locations, using the Speed parameter from the timeline.
-	ReturnTargetLocation = FMath::Lerp(InitialLocation,CalculatedCurveAxeLocation,Speed);
+	ReturnTargetLocation = FAxeThrowable::ReturnLocation(InitialLocation, AxeSocketTransform.GetLocation(),
+		Player->FollowCamera->GetRightVector(), DistanceFromCharacter, AxeReturnCurveScalar, AxeCurvature, Speed);
 
 	//Here calculate the Rotation (Axe changes tilt base on distance for polish effect, tilts more or less based on distance)
 	FRotator StartingRotator = FMath::Lerp(InitialRotator,FRotator(InitialCameraRotator.Pitch,InitialCameraRotator.Yaw,ReturnAxeTilt),InitialAlphaRotation);
 	//This rotator will start to blend with the Alpha once its closer to the AxeSocket, to adjust the axe to the hand of the player.
-	FRotator FinalRotator = FMath::Lerp(StartingRotator,Player->GetMesh()->GetSocketRotation(TEXT("AxeSocket")),CloseAlphaRotation);
+	FRotator FinalRotator = FMath::Lerp(StartingRotator,AxeSocketTransform.Rotator(),CloseAlphaRotation);
 	
 	
 	//Tick the Actor Location and Rotation based on the Timeline
@@ -321,6 +440,7 @@ void ALeviathanAxe::UpdateReturnAxePosition(float InitialAlphaRotation, float Cl
 
 float ALeviathanAxe::PlaySoundAndReturnAxeSpinTimelineRate(float TimelineRate)
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxePlaySoundAndReturnAxeSpinTimelineRate);
 	//Play all the sounds and stuff here.
 	//If its moving forward stop the rotation timeline.
 	StopSpinAxe();
@@ -330,6 +450,7 @@ float ALeviathanAxe::PlaySoundAndReturnAxeSpinTimelineRate(float TimelineRate)
 	float OffsettedLength = TimelineLength - ReturnSpinAxeStopDistanceOffset;
 	//Calculate the number of spin needed based on the spin rate.
 	NumberOfAxeSpins = FMath::RoundToInt(TimelineLength/ReturnAxeSpinRate);
+	TotalReturnSpins = NumberOfAxeSpins;
 	//Do the Length of the time line over the number of spins to get the length of the spins.
 	float SpinLength = OffsettedLength/NumberOfAxeSpins;
 	//Convert the SpinLength back to TimeLine Play rate, just divide again by 1
@@ -339,6 +460,7 @@ float ALeviathanAxe::PlaySoundAndReturnAxeSpinTimelineRate(float TimelineRate)
 
 void ALeviathanAxe::DecreaseNumberOfSpins(ESpinsFunctionOutputEnum& OutputPin)
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeDecreaseNumberOfSpins);
 	//If there's one spin remaining its already playing, so don't play again or you will get an extra one.
 	if(NumberOfAxeSpins == 1)
 	{
@@ -356,12 +478,14 @@ void ALeviathanAxe::DecreaseNumberOfSpins(ESpinsFunctionOutputEnum& OutputPin)
 // Called every frame
 void ALeviathanAxe::Tick(float DeltaTime)
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeTick);
 	Super::Tick(DeltaTime);
 
 }
 
 void ALeviathanAxe::MoveAxeToStartPosition()
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeMoveAxeToStartPosition);
 	//Add the offset to the camera
 	ThrowCameraLocation.X += SpinAxeAxisOffset;
 	//Calculate new location
@@ -383,13 +507,22 @@ void ALeviathanAxe::MoveAxeToStartPosition()
 
 void ALeviathanAxe::ProjectAxe()
 {
+	SCOPE_CYCLE_COUNTER(STAT_AxeProjectAxe);
 	//Set Projectile velocity of the axe now that is detached
 	ProjectileMovement->Velocity = ThrowDirection * ThrowSpeed;
-	//Activate Projectile movement
-	ProjectileMovement->Activate();
+	if(FlightComponent->bUseFixedStepFlight)
+	{
+		FlightComponent->Launch(GetActorLocation(), ProjectileMovement->Velocity);
+	}
+	else
+	{
+		//Activate Projectile movement
+		ProjectileMovement->Activate();
+	}
 	//Set enum to launched axe
 	AxeState = EAxeState::Launched;
 	//Start fancy particle effect trail
+	LEVIATHAN_LLM_SCOPE(AxeFX);
 	ThrowParticles->BeginTrails("BaseSocket","TipSocket",ETrailWidthMode_FromCentre
 		,1.0f);
 	//Remove gravity to simulate axe thrown very hard
@@ -7,6 +7,8 @@
 #include "GameFramework/Actor.h"
 #include "Engine/EngineTypes.h"
 #include "Particles/ParticleSystemComponent.h"
+#include "LeviathanAxeFlightModel.h"
+#include "LeviathanTrace.h"
 #include "UObject/ObjectMacros.h"
 
 #include "LeviathanAxe.generated.h"
@@ -20,6 +22,8 @@ enum class ESpinsFunctionOutputEnum : uint8 {Spinning,Done};
 
 UENUM()
 enum class EAxeState {Idle,Launched,Lodged,Returning };
+//Throw, lodge, recall and catch of the axe, broadcast once when they happen.
+DECLARE_MULTICAST_DELEGATE_TwoParams(FLeviathanAxeEvent, class ALeviathanAxe* /*Axe*/, ELeviathanAxeTraceEvent /*Event*/);
 UCLASS()
 class LEVIATHAN_API ALeviathanAxe : public AActor
 {
@@ -61,6 +65,12 @@ public:
 //Component for projectile calculations
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	class UProjectileMovementComponent* ProjectileMovement;
+	//Fixed step flight, replaces ProjectileMovement when its bUseFixedStepFlight is set.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+	class ULeviathanAxeFlightComponent* FlightComponent;
+	//Last seconds of the axe for kill-cams and replays.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+	class ULeviathanFlightRecorderComponent* FlightRecorder;
 
 //Particle Components
 #pragma region ParticleComponents
@@ -114,7 +124,7 @@ FRotator LodgePointBaseRotator;
 UPROPERTY(BlueprintReadWrite, EditAnywhere)
 float AxeImpulseStrength;
 //Offset for the spin axis of the axe. (Tilts the axe, so its thrown side ways for example)
-//This has potential to be used to change this code from an axe throw to a shield throw or other weapons.
+//The spin, lodge and return of other weapons (a shield throw) are policies in LeviathanThrowable.h.
 UPROPERTY(BlueprintReadWrite, EditAnywhere)
 float SpinAxeAxisOffset;
 //All of this is to be used to the Projectile movement component
@@ -132,6 +142,20 @@ UPROPERTY(BlueprintReadWrite)
 FName BoneHitName;
 UPROPERTY(EditDefaultsOnly)
 float AxeTraceDistance = 60.f;
+//Height above the actor location the lodge trace starts from (roughly where the blade is).
+UPROPERTY(EditDefaultsOnly)
+float AxeTraceZOffset = 41.f;
+//These describe the gravity curve the BP timeline feeds into ChangeGravityAndHit, keep them in sync with the curve.
+//The fixed step flight, the aim preview and the AI solver fly with them through GetFlightModel.
+//Seconds after the throw with no gravity.
+UPROPERTY(EditDefaultsOnly, Category = "AxeSettings")
+float ZeroGravityTime = 0.3f;
+//Seconds for the gravity scale to go from 0 to MaxGravityScale after that.
+UPROPERTY(EditDefaultsOnly, Category = "AxeSettings")
+float GravityRampTime = 0.5f;
+UPROPERTY(EditDefaultsOnly, Category = "AxeSettings")
+float MaxGravityScale = 1.f;
+FLeviathanAxeFlightModel GetFlightModel(float GravityZ) const;
 //Store the hit result of the linetracebychannel
 UPROPERTY(BlueprintReadOnly)
 FHitResult HitResult;
@@ -149,6 +173,8 @@ UPROPERTY(BlueprintReadWrite, EditAnywhere)
 FVector CurrentAxeLocation;
 //The number of spins to do when returning (This number changes based on the distance from the axe to the player)
 int NumberOfAxeSpins;
+//NumberOfAxeSpins before it starts counting down, kept for telemetry.
+int TotalReturnSpins = 0;
 //Float to set the maximum distance that the axe will do the calculation from (prevents from the axe to take
 //forever to return if it goes too far).
 UPROPERTY(BlueprintReadWrite, EditAnywhere)
@@ -206,6 +232,18 @@ UPROPERTY(EditAnywhere)
 float ReturnSpinAxeStopDistanceOffset = 0.1f;
 
 float AxeReturnTimelineSpeed;
+//Time stamps (FPlatformTime::Seconds) of the throw and the recall, used to time the flight and the return.
+double ThrowTimeSeconds = 0.0;
+double RecallTimeSeconds = 0.0;
+//Index of AxeSocket in the player's SocketCache.
+int32 AxeSocketIndex = INDEX_NONE;
+//For the HUD, so it doesn't have to poll the player every frame.
+FLeviathanAxeEvent OnAxeEvent;
+//Telemetry of the game instance if it records, looked up once in BeginPlay.
+UPROPERTY(Transient)
+class ULeviathanTelemetrySubsystem* Telemetry = nullptr;
+//Records the event to the throw telemetry, does nothing when it doesn't record.
+void RecordTelemetry(ELeviathanAxeTraceEvent Type) const;
 #pragma endregion
 
 
@@ -256,6 +294,10 @@ float AxeReturnTimelineSpeed;
 	
 	UFUNCTION(BlueprintCallable,Category="ThrowAxe")
 	bool ChangeGravityAndHit(float gravity);
+	//Handles the lodge trace in HitResult. Returns true if the axe should lodge.
+	bool HandleLodgeHit(const FVector& Velocity);
+	//Query params of the lodge trace, shared by ChangeGravityAndHit and ULeviathanAxeFlightComponent.
+	FCollisionQueryParams GetLodgeQueryParams() const;
 	UFUNCTION(BlueprintCallable, BlueprintImplementableEvent, Category = "SpinAxe")
 	void StartSpinAxe();
 	UFUNCTION(BlueprintCallable, BlueprintImplementableEvent, Category = "SpinAxe")
@@ -0,0 +1,133 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanAxeFlightComponent.h"
+
+#include "Leviathan.h"
+#include "LeviathanAxe.h"
+#include "LeviathanMemory.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("AxeFlight Tick"), STAT_AxeFlightTick, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("AxeFlight TraceFrame"), STAT_AxeFlightTraceFrame, STATGROUP_Leviathan);
+
+ULeviathanAxeFlightComponent::ULeviathanAxeFlightComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	//Same group ProjectileMovement moves the axe in.
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+}
+
+void ULeviathanAxeFlightComponent::Launch(const FVector& Location, const FVector& Velocity)
+{
+	ALeviathanAxe* Axe = Cast<ALeviathanAxe>(GetOwner());
+	if(!Axe)
+	{
+		return;
+	}
+
+	Current.Location = Location;
+	Current.Velocity = Velocity;
+	Current.FlightTime = 0.f;
+	Previous = Current;
+	Accumulator = 0.f;
+	bLodgePending = false;
+
+	//Same trace as ChangeGravityAndHit. The actor keeps ThrowCameraRotator while flying, only CenterPoint spins.
+	TraceDirection = Axe->GetActorRotation().Vector() * Axe->AxeTraceDistance;
+	TraceOffset = FVector(0.f, 0.f, Axe->AxeTraceZOffset);
+	Model = Axe->GetFlightModel(GetWorld()->GetGravityZ());
+	Step = 1.f / FixedStepHz;
+
+	bFlying = true;
+	SetComponentTickEnabled(true);
+}
+
+void ULeviathanAxeFlightComponent::Stop()
+{
+	bFlying = false;
+	SetComponentTickEnabled(false);
+}
+
+bool ULeviathanAxeFlightComponent::ConsumeLodge()
+{
+	const bool bLodged = bLodgePending;
+	bLodgePending = false;
+	return bLodged;
+}
+
+void ULeviathanAxeFlightComponent::TickComponent(float DeltaTime, ELevelTick TickType,
+	FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AxeFlightTick);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	ALeviathanAxe* Axe = Cast<ALeviathanAxe>(GetOwner());
+	if(!bFlying || !Axe)
+	{
+		return;
+	}
+	Accumulator += DeltaTime;
+	//A long hitch only simulates MaxStepsPerFrame steps, the rest of the time is dropped.
+	Accumulator = FMath::Min(Accumulator, Step * (MaxStepsPerFrame + 1));
+	const int32 NumSteps = FMath::Min(FMath::FloorToInt(Accumulator / Step), MaxStepsPerFrame);
+
+	if(NumSteps > 0)
+	{
+		const FLeviathanAxeFlightState FrameStart = Current;
+		for(int32 StepIndex = 0; StepIndex < NumSteps; StepIndex++)
+		{
+			Previous = Current;
+			Model.Step(Current.Location, Current.Velocity, Current.FlightTime, Step);
+		}
+		Accumulator -= NumSteps * Step;
+
+		if(TraceFrame(*Axe, FrameStart, NumSteps))
+		{
+			//Stop where the trace hit, LodgeAxe moves it onto the surface.
+			Axe->SetActorLocation(Current.Location);
+			bLodgePending = true;
+			Stop();
+			return;
+		}
+	}
+
+	//Draw between the last two steps so the axe moves smoothly at any frame rate.
+	const float Alpha = FMath::Clamp(Accumulator / Step, 0.f, 1.f);
+	Axe->SetActorLocation(FMath::Lerp(Previous.Location, Current.Location, Alpha));
+}
+
+bool ULeviathanAxeFlightComponent::TraceFrame(ALeviathanAxe& Axe, const FLeviathanAxeFlightState& FrameStart,
+	int32 NumSteps)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AxeFlightTraceFrame);
+	LEVIATHAN_LLM_SCOPE(AxeTraces);
+	//The probe of ChangeGravityAndHit runs AxeTraceDistance ahead of the axe. Sweeping from the probe start of the
+	//first step to the probe end of the last one covers every step's probe, at 120 Hz the path of a frame is as good as
+	//straight.
+	const FVector Start = FrameStart.Location + TraceOffset;
+	const FVector End = Current.Location + TraceOffset + TraceDirection;
+	if(!GetWorld()->LineTraceSingleByChannel(Axe.HitResult, Start, End, ECC_Visibility, Axe.GetLodgeQueryParams()))
+	{
+		return false;
+	}
+	if(!Axe.HandleLodgeHit(Current.Velocity))
+	{
+		//Broke a prop, fly on.
+		return false;
+	}
+	//Stop at the first step whose probe reaches the surface, as ChangeGravityAndHit would have.
+	const FVector Direction = (End - Start).GetSafeNormal();
+	const float HitAlong = (Axe.HitResult.Location - Start) | Direction;
+	FLeviathanAxeFlightState State = FrameStart;
+	for(int32 StepIndex = 0; StepIndex < NumSteps; StepIndex++)
+	{
+		Model.Step(State.Location, State.Velocity, State.FlightTime, Step);
+		if(((State.Location + TraceOffset + TraceDirection - Start) | Direction) >= HitAlong)
+		{
+			break;
+		}
+	}
+	Current = State;
+	return true;
+}
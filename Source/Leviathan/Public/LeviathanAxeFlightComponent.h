@@ -0,0 +1,71 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Engine/EngineTypes.h"
+#include "LeviathanAxeFlightModel.h"
+
+#include "LeviathanAxeFlightComponent.generated.h"
+
+//Fixed step state of the axe in flight.
+struct FLeviathanAxeFlightState
+{
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	//Seconds since the throw, drives the gravity ramp.
+	float FlightTime = 0.f;
+};
+
+/**Optional replacement for the ProjectileMovement + BP timeline flight of ALeviathanAxe.
+ * The flight (FLeviathanAxeFlightModel) is integrated at a fixed rate, so it is identical at any frame rate, and
+ * ProjectileMovement (its sweep and the component move it does every frame) is not ticked at all. The steps are a few
+ * multiply-adds each and run inline, the lodge is found with one line trace over the path of the whole frame, the same
+ * one trace per frame ChangeGravityAndHit does. A lodge is handed to the axe through ConsumeLodge.
+ */
+UCLASS(ClassGroup = (Axe), meta = (BlueprintSpawnableComponent))
+class LEVIATHAN_API ULeviathanAxeFlightComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	ULeviathanAxeFlightComponent();
+
+	//When false the axe flies with ProjectileMovement and the BP timeline as before.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AxeSettings")
+	bool bUseFixedStepFlight = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AxeSettings", meta = (ClampMin = "30", ClampMax = "480"))
+	float FixedStepHz = 120.f;
+
+	//Caps the steps of one frame so a hitch doesn't turn into a long jump.
+	UPROPERTY(EditAnywhere, Category = "AxeSettings", meta = (ClampMin = "1"))
+	int32 MaxStepsPerFrame = 16;
+
+	//Starts flying from Location. Only called by ALeviathanAxe::ProjectAxe when bUseFixedStepFlight is set.
+	void Launch(const FVector& Location, const FVector& Velocity);
+	void Stop();
+	bool IsFlying() const { return bFlying; }
+	//True once after the flight lodged, ChangeGravityAndHit hands it to the BP so it calls LodgeAxe as before.
+	bool ConsumeLodge();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
+		FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+	//Traces the path from FrameStart to Current, returns true if the axe lodged.
+	bool TraceFrame(class ALeviathanAxe& Axe, const FLeviathanAxeFlightState& FrameStart, int32 NumSteps);
+
+	FLeviathanAxeFlightModel Model;
+	float Step = 1.f / 120.f;
+	FVector TraceDirection = FVector::ZeroVector;
+	FVector TraceOffset = FVector::ZeroVector;
+
+	FLeviathanAxeFlightState Previous;
+	FLeviathanAxeFlightState Current;
+	//Frame time not simulated yet, always under one step after a tick.
+	float Accumulator = 0.f;
+	bool bFlying = false;
+	bool bLodgePending = false;
+};
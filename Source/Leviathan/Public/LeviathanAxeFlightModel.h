@@ -0,0 +1,46 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**The axe flight after the throw: straight for ZeroGravityTime, then the gravity scale ramps up to MaxGravityScale
+ * over GravityRampTime (the curve the BP timeline feeds into ChangeGravityAndHit).
+ * The fixed step flight, the aim preview and the AI ballistic solver all fly the axe through this, keep it the only
+ * place that knows the curve.
+ */
+struct FLeviathanAxeFlightModel
+{
+	float GravityZ = -980.f;
+	float ZeroGravityTime = 0.3f;
+	float GravityRampTime = 0.5f;
+	float MaxGravityScale = 1.f;
+
+	//Gravity scale FlightTime seconds after the throw.
+	FORCEINLINE float GravityScale(float FlightTime) const
+	{
+		const float RampAlpha = GravityRampTime > 0.f
+			? FMath::Clamp((FlightTime - ZeroGravityTime) / GravityRampTime, 0.f, 1.f)
+			: (FlightTime >= ZeroGravityTime ? 1.f : 0.f);
+		return MaxGravityScale * RampAlpha;
+	}
+
+	//Advances one step of DeltaTime seconds, gravity first like ProjectileMovement.
+	FORCEINLINE void Step(FVector& Location, FVector& Velocity, float& FlightTime, float DeltaTime) const
+	{
+		Velocity.Z += GravityZ * GravityScale(FlightTime) * DeltaTime;
+		Location += Velocity * DeltaTime;
+		FlightTime += DeltaTime;
+	}
+
+	//How far gravity has pulled the axe down after Time seconds (negative with negative GravityZ), the exact
+	//integral of GravityScale that Step approaches as the step gets small.
+	FORCEINLINE float GravityDrop(float Time) const
+	{
+		const float RampTime = FMath::Max(GravityRampTime, KINDA_SMALL_NUMBER);
+		const float InRamp = FMath::Clamp(Time - ZeroGravityTime, 0.f, RampTime);
+		const float AfterRamp = FMath::Max(Time - ZeroGravityTime - RampTime, 0.f);
+		return GravityZ * MaxGravityScale * (InRamp * InRamp * InRamp / (6.f * RampTime)
+			+ 0.5f * RampTime * AfterRamp + 0.5f * AfterRamp * AfterRamp);
+	}
+};
@@ -0,0 +1,334 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Leviathan.h"
+#include "LeviathanAxe.h"
+#include "LeviathanCharacter.h"
+#include "LeviathanPerfBudget.h"
+#include "Camera/CameraComponent.h"
+#include "Components/ChildActorComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Tests/AutomationCommon.h"
+
+/**Throws the axe at fixed targets on ThirdPersonExampleMap, lodges and recalls it, checks the axe and character state
+ * after each phase and fails when Throw, ChangeGravityAndHit, UpdateReturnAxePosition or CatchAxe went over its budget
+ * in ULeviathanPerfSettings. Every run writes the perf report to Saved/Profiling/Leviathan.
+ * Run in a game world, e.g.:
+ *   UE4Editor-Cmd Leviathan -game -nullrhi -unattended -ExecCmds="Automation RunTests Leviathan.Axe; Quit"
+ * -LeviathanPerfMargin=<percent> overrides BudgetMarginPercent.
+ */
+namespace LeviathanAxeTests
+{
+	static const TCHAR* MapPath = TEXT("/Game/ThirdPersonCPP/Maps/ThirdPersonExampleMap");
+
+	//The test plays the BP timelines: seconds of flight before giving up, frames of the return.
+	static constexpr float MaxFlightSeconds = 3.f;
+	static constexpr int32 ReturnFrames = 30;
+	static constexpr float ReturnCurvature = 0.2f;
+
+	struct FTarget
+	{
+		const TCHAR* Name;
+		//In the character's space where the test starts.
+		FVector Offset;
+	};
+
+	static const FTarget Targets[] =
+	{
+		{ TEXT("Front"), FVector(700.f, 0.f, 50.f) },
+		{ TEXT("FarFront"), FVector(1100.f, 0.f, 50.f) },
+		{ TEXT("Left"), FVector(600.f, -350.f, 50.f) },
+		{ TEXT("Right"), FVector(600.f, 350.f, 50.f) },
+	};
+
+	static UWorld* GetGameWorld()
+	{
+		for(const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			if((Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE) && Context.World())
+			{
+				return Context.World();
+			}
+		}
+		return nullptr;
+	}
+
+	//Fails the test through the same budget check as Leviathan.Perf.Report.
+	static void CheckBudgets(FAutomationTestBase& Test)
+	{
+		const FLeviathanPerfBudget& Budget = FLeviathanPerfBudget::Get();
+		static const FName MeasuredFunctions[] =
+			{ TEXT("Throw"), TEXT("ChangeGravityAndHit"), TEXT("UpdateReturnAxePosition"), TEXT("CatchAxe") };
+		for(const FName& Function : MeasuredFunctions)
+		{
+			const FLeviathanPerfSample* Sample = Budget.GetSamples().Find(Function);
+			Test.TestTrue(FString::Printf(TEXT("%s was measured"), *Function.ToString()), Sample && Sample->Calls > 0);
+		}
+
+		float MarginPercent = GetDefault<ULeviathanPerfSettings>()->BudgetMarginPercent;
+		FParse::Value(FCommandLine::Get(), TEXT("LeviathanPerfMargin="), MarginPercent);
+		FString ReportPath;
+		if(Budget.WriteReport(MarginPercent, ReportPath))
+		{
+			Test.AddInfo(FString::Printf(TEXT("Axe perf report passed: %s"), *ReportPath));
+		}
+		else
+		{
+			Test.AddError(FString::Printf(TEXT("Axe perf budget exceeded (margin %.1f%%), see %s"), MarginPercent,
+				*ReportPath));
+		}
+	}
+}
+
+//Throw, lodge, recall and catch against one target, one phase per frame or more.
+class FLeviathanAxeLifecycleCommand : public IAutomationLatentCommand
+{
+public:
+	FLeviathanAxeLifecycleCommand(FAutomationTestBase* InTest, const FVector& InTargetOffset)
+		: Test(InTest)
+		, TargetOffset(InTargetOffset)
+	{
+	}
+
+	virtual bool Update() override;
+
+private:
+	enum class EPhase : uint8 { Setup, Aim, Flight, Return };
+
+	bool Setup(UWorld* World);
+	bool Fail(const FString& Message);
+	void Cleanup();
+
+	FAutomationTestBase* Test;
+	FVector TargetOffset;
+	EPhase Phase = EPhase::Setup;
+	double SetupStartTime = 0.0;
+	int32 AimFrames = 0;
+	float FlightTime = 0.f;
+	int32 ReturnFrame = 0;
+
+	TWeakObjectPtr<ALeviathanCharacter> Character;
+	TWeakObjectPtr<ALeviathanAxe> Axe;
+	TWeakObjectPtr<AActor> Target;
+};
+
+bool FLeviathanAxeLifecycleCommand::Fail(const FString& Message)
+{
+	Test->AddError(Message);
+	Cleanup();
+	return true;
+}
+
+void FLeviathanAxeLifecycleCommand::Cleanup()
+{
+	if(Target.IsValid())
+	{
+		Target->Destroy();
+	}
+	if(Character.IsValid())
+	{
+		Character->bAiming = false;
+	}
+}
+
+bool FLeviathanAxeLifecycleCommand::Setup(UWorld* World)
+{
+	APlayerController* Controller = World->GetFirstPlayerController();
+	Character = Controller ? Cast<ALeviathanCharacter>(Controller->GetPawn()) : nullptr;
+	if(!Character.IsValid())
+	{
+		return false;
+	}
+	Axe = Cast<ALeviathanAxe>(Character->LeviathanAxeChildActorComponent->GetChildActor());
+	if(!Axe.IsValid())
+	{
+		return false;
+	}
+
+	//A wall across the throw, square to the character.
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AStaticMeshActor* Wall = World->SpawnActor<AStaticMeshActor>(
+		Character->GetActorTransform().TransformPosition(TargetOffset), FRotator(0.f, Character->GetActorRotation().Yaw,
+		0.f), SpawnParams);
+	if(!Wall)
+	{
+		return false;
+	}
+	Wall->SetMobility(EComponentMobility::Movable);
+	Wall->GetStaticMeshComponent()->SetStaticMesh(LoadObject<UStaticMesh>(nullptr,
+		TEXT("/Engine/BasicShapes/Cube.Cube")));
+	Wall->GetStaticMeshComponent()->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	Wall->SetActorScale3D(FVector(0.5f, 2.5f, 2.5f));
+	Target = Wall;
+
+	FLeviathanPerfBudget::Get().Reset();
+	Character->bAiming = true;
+	return true;
+}
+
+bool FLeviathanAxeLifecycleCommand::Update()
+{
+	UWorld* World = LeviathanAxeTests::GetGameWorld();
+	if(!World)
+	{
+		return Fail(TEXT("No game world, run the test with -game"));
+	}
+
+	switch(Phase)
+	{
+		case EPhase::Setup:
+		{
+			if(SetupStartTime == 0.0)
+			{
+				SetupStartTime = FPlatformTime::Seconds();
+			}
+			if(!Setup(World))
+			{
+				//The pawn can take a few frames to be possessed after the map loaded.
+				return FPlatformTime::Seconds() - SetupStartTime > 10.0
+					? Fail(TEXT("No ALeviathanCharacter with an ALeviathanAxe in the map"))
+					: false;
+			}
+			Test->TestFalse(TEXT("Axe starts in the hand"), Character->bAxeThrown);
+			Test->TestTrue(TEXT("Can throw while aiming"), Character->CanThrowAxe());
+			Phase = EPhase::Aim;
+			return false;
+		}
+		case EPhase::Aim:
+		{
+			if(!Character.IsValid() || !Axe.IsValid() || !Target.IsValid())
+			{
+				return Fail(TEXT("Character, axe or target went away while aiming"));
+			}
+			//The camera moves with the aim (boom socket offset), settle for a few frames.
+			const FVector CameraLocation = Character->FollowCamera->GetComponentLocation();
+			Character->GetController()->SetControlRotation((Target->GetActorLocation() - CameraLocation).Rotation());
+			if(++AimFrames < 3)
+			{
+				return false;
+			}
+
+			Axe->Throw();
+			Test->TestTrue(TEXT("Thrown after Throw"), Character->bAxeThrown);
+			Test->TestTrue(TEXT("Launched after Throw"), Axe->AxeState == EAxeState::Launched);
+			Test->TestFalse(TEXT("Can't throw twice"), Character->CanThrowAxe());
+			FlightTime = 0.f;
+			Phase = EPhase::Flight;
+			return false;
+		}
+		case EPhase::Flight:
+		{
+			if(!Character.IsValid() || !Axe.IsValid())
+			{
+				return Fail(TEXT("Character or axe went away in flight"));
+			}
+			//What GravityThrowTimeline does in the BP: feed the gravity curve and lodge on the first hit.
+			FlightTime += World->GetDeltaSeconds();
+			const float GravityScale = Axe->GetFlightModel(World->GetGravityZ()).GravityScale(FlightTime);
+			if(!Axe->ChangeGravityAndHit(GravityScale))
+			{
+				return FlightTime > LeviathanAxeTests::MaxFlightSeconds
+					? Fail(FString::Printf(TEXT("Axe did not lodge within %.1f s"), LeviathanAxeTests::MaxFlightSeconds))
+					: false;
+			}
+			Axe->LodgeAxe(nullptr, nullptr, nullptr);
+			Test->TestTrue(TEXT("Lodged after LodgeAxe"), Axe->AxeState == EAxeState::Lodged);
+			Test->TestTrue(TEXT("Lodged in the target"), Axe->HitResult.GetActor() == Target.Get());
+			Test->TestTrue(TEXT("Still thrown while lodged"), Character->bAxeThrown);
+			Test->TestTrue(TEXT("Can recall while lodged"), Character->CanRecallAxe());
+
+			//What the Recall Event does before the return timeline, without the wiggle.
+			ESetupEnum OutputPin = ESetupEnum::Launched;
+			Axe->SetupWiggleReturn(nullptr, nullptr, OutputPin);
+			Test->TestTrue(TEXT("Lodged axe wiggles first"), OutputPin == ESetupEnum::Lodged);
+			Axe->StartParticleTrail();
+			Axe->SetupTimelineReturn();
+			Test->TestTrue(TEXT("Recalled after SetupTimelineReturn"), Character->bAxeRecalled);
+			Test->TestTrue(TEXT("Returning after SetupTimelineReturn"), Axe->AxeState == EAxeState::Returning);
+			Test->TestFalse(TEXT("Can't recall twice"), Character->CanRecallAxe());
+			ReturnFrame = 0;
+			Phase = EPhase::Return;
+			return false;
+		}
+		case EPhase::Return:
+		{
+			if(!Character.IsValid() || !Axe.IsValid())
+			{
+				return Fail(TEXT("Character or axe went away on the return"));
+			}
+			//The return timeline, one point per frame.
+			const float Alpha = float(++ReturnFrame) / LeviathanAxeTests::ReturnFrames;
+			Axe->UpdateReturnAxePosition(Alpha, Alpha * Alpha,
+				FMath::Sin(Alpha * PI) * LeviathanAxeTests::ReturnCurvature, Alpha, Alpha);
+			if(ReturnFrame < LeviathanAxeTests::ReturnFrames)
+			{
+				return false;
+			}
+
+			Character->CatchAxe(Axe.Get());
+			Test->TestFalse(TEXT("Not thrown after CatchAxe"), Character->bAxeThrown);
+			Test->TestFalse(TEXT("Not recalled after CatchAxe"), Character->bAxeRecalled);
+			Test->TestTrue(TEXT("Idle after CatchAxe"), Axe->AxeState == EAxeState::Idle);
+			Test->TestTrue(TEXT("Back in the hand after CatchAxe"), Axe->GetAttachParentActor() == Character.Get());
+
+			LeviathanAxeTests::CheckBudgets(*Test);
+			Cleanup();
+			return true;
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FLeviathanAxeLifecycleTest, "Leviathan.Axe.Lifecycle",
+	EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+void FLeviathanAxeLifecycleTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for(const LeviathanAxeTests::FTarget& Target : LeviathanAxeTests::Targets)
+	{
+		OutBeautifiedNames.Add(Target.Name);
+		OutTestCommands.Add(Target.Name);
+	}
+}
+
+bool FLeviathanAxeLifecycleTest::RunTest(const FString& Parameters)
+{
+	const LeviathanAxeTests::FTarget* Target = nullptr;
+	for(const LeviathanAxeTests::FTarget& Candidate : LeviathanAxeTests::Targets)
+	{
+		if(Parameters == Candidate.Name)
+		{
+			Target = &Candidate;
+		}
+	}
+	if(!Target)
+	{
+		AddError(FString::Printf(TEXT("Unknown target %s"), *Parameters));
+		return false;
+	}
+	//FLoadGameMapCommand opens the map in the game world, there is none in the editor.
+	if(GIsEditor)
+	{
+		AddError(TEXT("Leviathan.Axe tests need a game world, run them with -game"));
+		return false;
+	}
+
+	ADD_LATENT_AUTOMATION_COMMAND(FLoadGameMapCommand(LeviathanAxeTests::MapPath));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitForMapToLoadCommand());
+	ADD_LATENT_AUTOMATION_COMMAND(FLeviathanAxeLifecycleCommand(this, Target->Offset));
+	return true;
+}
+
+#endif
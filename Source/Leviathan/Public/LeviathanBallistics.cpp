@@ -0,0 +1,315 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanBallistics.h"
+
+#include "Leviathan.h"
+#include "LeviathanAxe.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/Parse.h"
+
+DECLARE_CYCLE_STAT(TEXT("Ballistics SolveBatch"), STAT_BallisticsSolveBatch, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Ballistics Tick"), STAT_BallisticsTick, STATGROUP_Leviathan);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ballistics Solves"), STAT_BallisticsSolves, STATGROUP_Leviathan);
+
+//Coarse samples over MaxFlightTime to find the first time the axe can reach the target, then bisection steps.
+static constexpr int32 BracketSamples = 32;
+static constexpr int32 BisectionSteps = 16;
+
+FLeviathanBallisticParams FLeviathanBallisticParams::FromAxe(const ALeviathanAxe& Axe, float GravityZ)
+{
+	FLeviathanBallisticParams Params;
+	const FLeviathanAxeFlightModel Model = Axe.GetFlightModel(GravityZ);
+	Params.Speed = Axe.ThrowSpeed;
+	Params.GravityZ = Model.GravityZ;
+	Params.ZeroGravityTime = Model.ZeroGravityTime;
+	Params.GravityRampTime = Model.GravityRampTime;
+	Params.MaxGravityScale = Model.MaxGravityScale;
+	return Params;
+}
+
+FVector FLeviathanBallisticSolver::Simulate(const FLeviathanBallisticParams& Params, const FVector& Direction, float Time)
+{
+	return Direction * Params.Speed * Time + FVector(0.f, 0.f, Params.GravityDrop(Time));
+}
+
+void FLeviathanBallisticSolver::SolveBatch(const FLeviathanBallisticParams& Params,
+	TArrayView<const FLeviathanBallisticRequest> Requests, TArrayView<FLeviathanBallisticSolution> OutSolutions,
+	bool bForceSingleThread)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BallisticsSolveBatch);
+	check(OutSolutions.Num() >= Requests.Num());
+	INC_DWORD_STAT_BY(STAT_BallisticsSolves, Requests.Num());
+
+	const int32 NumChunks = FMath::DivideAndRoundUp(Requests.Num(), LaneCount);
+	ParallelFor(NumChunks, [&Params, &Requests, &OutSolutions](int32 Chunk)
+	{
+		const int32 First = Chunk * LaneCount;
+		SolveChunk(Params, Requests.GetData() + First, OutSolutions.GetData() + First,
+			FMath::Min(LaneCount, Requests.Num() - First));
+	}, bForceSingleThread || NumChunks == 1);
+}
+
+void FLeviathanBallisticSolver::SolveChunk(const FLeviathanBallisticParams& Params,
+	const FLeviathanBallisticRequest* Requests, FLeviathanBallisticSolution* OutSolutions, int32 Count)
+{
+	//Target relative to the shooter and its velocity, one array per component so every loop below runs over
+	//contiguous floats. Unused lanes repeat the last request.
+	alignas(64) float RelX[LaneCount], RelY[LaneCount], RelZ[LaneCount];
+	alignas(64) float VelX[LaneCount], VelY[LaneCount], VelZ[LaneCount];
+	alignas(64) float Low[LaneCount], High[LaneCount], Found[LaneCount];
+	for(int32 Lane = 0; Lane < LaneCount; Lane++)
+	{
+		const FLeviathanBallisticRequest& Request = Requests[FMath::Min(Lane, Count - 1)];
+		const FVector Rel = Request.Target - Request.Shooter;
+		RelX[Lane] = Rel.X;
+		RelY[Lane] = Rel.Y;
+		RelZ[Lane] = Rel.Z;
+		VelX[Lane] = Request.TargetVelocity.X;
+		VelY[Lane] = Request.TargetVelocity.Y;
+		VelZ[Lane] = Request.TargetVelocity.Z;
+		High[Lane] = 0.f;
+		Found[Lane] = 0.f;
+	}
+
+	//The axe meets the target at T when the distance to where the target will be, corrected for the gravity drop,
+	//is exactly what the axe covers in T: |Rel + Vel T - Drop(T)| - Speed T = 0. Negative means reachable.
+	const float Speed = Params.Speed;
+	auto Miss = [&](int32 Lane, float Time, float Drop)
+	{
+		const float X = RelX[Lane] + VelX[Lane] * Time;
+		const float Y = RelY[Lane] + VelY[Lane] * Time;
+		const float Z = RelZ[Lane] + VelZ[Lane] * Time - Drop;
+		return FMath::Sqrt(X * X + Y * Y + Z * Z) - Speed * Time;
+	};
+
+	const float SampleStep = Params.MaxFlightTime / BracketSamples;
+	for(int32 Sample = 1; Sample <= BracketSamples; Sample++)
+	{
+		const float Time = Sample * SampleStep;
+		const float Drop = Params.GravityDrop(Time);
+		for(int32 Lane = 0; Lane < LaneCount; Lane++)
+		{
+			//Only the first reachable sample counts, a steep drop makes far ones reachable again later.
+			const float Crossed = (Miss(Lane, Time, Drop) < 0.f && Found[Lane] == 0.f) ? 1.f : 0.f;
+			High[Lane] = Crossed > 0.f ? Time : High[Lane];
+			Found[Lane] = FMath::Max(Found[Lane], Crossed);
+		}
+	}
+	for(int32 Lane = 0; Lane < LaneCount; Lane++)
+	{
+		Low[Lane] = FMath::Max(High[Lane] - SampleStep, 0.f);
+	}
+
+	for(int32 Step = 0; Step < BisectionSteps; Step++)
+	{
+		for(int32 Lane = 0; Lane < LaneCount; Lane++)
+		{
+			const float Mid = 0.5f * (Low[Lane] + High[Lane]);
+			const bool bReachable = Miss(Lane, Mid, Params.GravityDrop(Mid)) < 0.f;
+			High[Lane] = bReachable ? Mid : High[Lane];
+			Low[Lane] = bReachable ? Low[Lane] : Mid;
+		}
+	}
+
+	for(int32 Lane = 0; Lane < Count; Lane++)
+	{
+		FLeviathanBallisticSolution& Solution = OutSolutions[Lane];
+		Solution.bValid = Found[Lane] > 0.f;
+		if(!Solution.bValid)
+		{
+			Solution = FLeviathanBallisticSolution();
+			continue;
+		}
+		const float Time = High[Lane];
+		const FVector TargetAtTime = FVector(RelX[Lane], RelY[Lane], RelZ[Lane])
+			+ FVector(VelX[Lane], VelY[Lane], VelZ[Lane]) * Time;
+		Solution.FlightTime = Time;
+		Solution.Direction = (TargetAtTime - FVector(0.f, 0.f, Params.GravityDrop(Time))).GetSafeNormal();
+		Solution.AimPoint = Requests[Lane].Shooter + TargetAtTime;
+	}
+}
+
+bool ULeviathanBallisticsSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void ULeviathanBallisticsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	ThrowParams = FLeviathanBallisticParams::FromAxe(*GetDefault<ALeviathanAxe>(), GetWorld()->GetGravityZ());
+}
+
+void ULeviathanBallisticsSubsystem::Deinitialize()
+{
+	//Tasks reference the batches, they must finish before those go.
+	FTaskGraphInterface::Get().WaitUntilTasksComplete(InFlightTasks, ENamedThreads::GameThread);
+	InFlightTasks.Reset();
+	InFlight.Reset();
+	Queued.Reset();
+	SingleRequests.Reset();
+	SingleCallbacks.Reset();
+	Super::Deinitialize();
+}
+
+ETickableTickType ULeviathanBallisticsSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId ULeviathanBallisticsSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULeviathanBallisticsSubsystem, STATGROUP_Tickables);
+}
+
+void ULeviathanBallisticsSubsystem::SetThrowParamsFromAxe(ALeviathanAxe* Axe)
+{
+	if(Axe)
+	{
+		ThrowParams = FLeviathanBallisticParams::FromAxe(*Axe, GetWorld()->GetGravityZ());
+	}
+}
+
+void ULeviathanBallisticsSubsystem::SolveThrowAsync(FVector Shooter, FVector Target, FVector TargetVelocity,
+	FLeviathanBallisticSolved OnSolved)
+{
+	FLeviathanBallisticRequest& Request = SingleRequests.AddDefaulted_GetRef();
+	Request.Shooter = Shooter;
+	Request.Target = Target;
+	Request.TargetVelocity = TargetVelocity;
+	SingleCallbacks.Add(OnSolved);
+}
+
+void ULeviathanBallisticsSubsystem::SubmitBatch(const FLeviathanBallisticParams& Params,
+	TArray<FLeviathanBallisticRequest> Requests, FLeviathanBallisticBatchDone OnDone)
+{
+	TSharedPtr<FBatch> Batch = MakeShared<FBatch>();
+	Batch->Params = Params;
+	Batch->Requests = MoveTemp(Requests);
+	Batch->OnDone = MoveTemp(OnDone);
+	Queued.Add(Batch);
+}
+
+void ULeviathanBallisticsSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BallisticsTick);
+	//Last frame's batches first, they had a whole frame on the workers.
+	DeliverInFlight();
+
+	if(SingleRequests.Num() > 0)
+	{
+		TArray<FLeviathanBallisticSolved> Callbacks = MoveTemp(SingleCallbacks);
+		SubmitBatch(ThrowParams, MoveTemp(SingleRequests), FLeviathanBallisticBatchDone::CreateLambda(
+			[Callbacks](const TArray<FLeviathanBallisticSolution>& Solutions)
+		{
+			for(int32 Index = 0; Index < Callbacks.Num(); Index++)
+			{
+				Callbacks[Index].ExecuteIfBound(Solutions[Index]);
+			}
+		}));
+		SingleRequests.Reset();
+		SingleCallbacks.Reset();
+	}
+	DispatchQueued();
+}
+
+void ULeviathanBallisticsSubsystem::DispatchQueued()
+{
+	for(TSharedPtr<FBatch>& Batch : Queued)
+	{
+		Batch->Solutions.SetNum(Batch->Requests.Num());
+		FBatch* BatchPtr = Batch.Get();
+		InFlightTasks.Add(FFunctionGraphTask::CreateAndDispatchWhenReady([BatchPtr]()
+		{
+			FLeviathanBallisticSolver::SolveBatch(BatchPtr->Params, BatchPtr->Requests, BatchPtr->Solutions);
+		}, TStatId(), nullptr, ENamedThreads::AnyBackgroundThreadNormalTask));
+		InFlight.Add(MoveTemp(Batch));
+	}
+	Queued.Reset();
+}
+
+void ULeviathanBallisticsSubsystem::DeliverInFlight()
+{
+	if(InFlight.Num() == 0)
+	{
+		return;
+	}
+	//Normally done long ago, only waits on a hitch of the workers.
+	FTaskGraphInterface::Get().WaitUntilTasksComplete(InFlightTasks, ENamedThreads::GameThread);
+	InFlightTasks.Reset();
+	//Callbacks may submit new batches.
+	TArray<TSharedPtr<FBatch>> Done = MoveTemp(InFlight);
+	InFlight.Reset();
+	for(const TSharedPtr<FBatch>& Batch : Done)
+	{
+		Batch->OnDone.ExecuteIfBound(Batch->Solutions);
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+/**Leviathan.Ballistics.Bench [Iterations=20]
+ * Solves random batches of 1, 10, 100 and 1000 moving targets, on the workers and on one thread, and checks the
+ * solutions by flying them.*/
+static FAutoConsoleCommandWithArgs BallisticsBenchCommand(
+	TEXT("Leviathan.Ballistics.Bench"),
+	TEXT("Logs solves per millisecond of the axe ballistic solver for batches of 1 to 1000. Iterations=20."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		int32 Iterations = 20;
+		for(const FString& Arg : Args)
+		{
+			FParse::Value(*Arg, TEXT("Iterations="), Iterations);
+		}
+		Iterations = FMath::Max(Iterations, 1);
+		const FLeviathanBallisticParams Params = FLeviathanBallisticParams::FromAxe(*GetDefault<ALeviathanAxe>(), -980.f);
+
+		FRandomStream Random(1234);
+		for(const int32 BatchSize : { 1, 10, 100, 1000 })
+		{
+			TArray<FLeviathanBallisticRequest> Requests;
+			TArray<FLeviathanBallisticSolution> Solutions;
+			Requests.SetNum(BatchSize);
+			Solutions.SetNum(BatchSize);
+			for(FLeviathanBallisticRequest& Request : Requests)
+			{
+				Request.Shooter = FVector(0.f, 0.f, 150.f);
+				Request.Target = Random.GetUnitVector() * FVector(1.f, 1.f, 0.2f) * Random.FRandRange(300.f, 4000.f);
+				Request.TargetVelocity = Random.GetUnitVector() * FVector(1.f, 1.f, 0.f) * Random.FRandRange(0.f, 600.f);
+			}
+
+			double Milliseconds[2];
+			for(int32 SingleThread = 0; SingleThread < 2; SingleThread++)
+			{
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				for(int32 Iteration = 0; Iteration < Iterations; Iteration++)
+				{
+					FLeviathanBallisticSolver::SolveBatch(Params, Requests, Solutions, SingleThread == 1);
+				}
+				Milliseconds[SingleThread] = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles)
+					/ Iterations;
+			}
+
+			int32 Valid = 0;
+			float WorstError = 0.f;
+			for(int32 Index = 0; Index < BatchSize; Index++)
+			{
+				const FLeviathanBallisticSolution& Solution = Solutions[Index];
+				if(Solution.bValid)
+				{
+					Valid++;
+					const FVector Landed = Requests[Index].Shooter
+						+ FLeviathanBallisticSolver::Simulate(Params, Solution.Direction, Solution.FlightTime);
+					WorstError = FMath::Max(WorstError, FVector::Dist(Landed, Solution.AimPoint));
+				}
+			}
+			UE_LOG(LogLeviathan, Display, TEXT("Ballistics batch %4d: %.4f ms (%.1f solves/ms) parallel, %.4f ms ")
+				TEXT("(%.1f solves/ms) single thread, %d solvable, worst miss %.2f"), BatchSize, Milliseconds[0],
+				BatchSize / FMath::Max(Milliseconds[0], 1e-6), Milliseconds[1], BatchSize / FMath::Max(Milliseconds[1], 1e-6),
+				Valid, WorstError);
+		}
+	}));
+#endif
@@ -0,0 +1,161 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "LeviathanAxeFlightModel.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+
+#include "LeviathanBallistics.generated.h"
+
+//Flight model of ALeviathanAxe: straight at Speed, no gravity for ZeroGravityTime, then gravity ramping up.
+USTRUCT(BlueprintType)
+struct FLeviathanBallisticParams
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics)
+	float Speed = 2500.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics)
+	float GravityZ = -980.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics)
+	float ZeroGravityTime = 0.3f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics)
+	float GravityRampTime = 0.5f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics)
+	float MaxGravityScale = 1.f;
+	//Longest flight considered, targets that can't be reached sooner get no solution.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics)
+	float MaxFlightTime = 3.f;
+
+	static FLeviathanBallisticParams FromAxe(const class ALeviathanAxe& Axe, float GravityZ);
+
+	FORCEINLINE FLeviathanAxeFlightModel GetFlightModel() const
+	{
+		FLeviathanAxeFlightModel Model;
+		Model.GravityZ = GravityZ;
+		Model.ZeroGravityTime = ZeroGravityTime;
+		Model.GravityRampTime = GravityRampTime;
+		Model.MaxGravityScale = MaxGravityScale;
+		return Model;
+	}
+
+	//How far gravity has pulled the axe down after Time seconds (negative with negative GravityZ).
+	FORCEINLINE float GravityDrop(float Time) const
+	{
+		return GetFlightModel().GravityDrop(Time);
+	}
+};
+
+USTRUCT(BlueprintType)
+struct FLeviathanBallisticRequest
+{
+	GENERATED_BODY()
+
+	//Where the axe starts flying from.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics)
+	FVector Shooter = FVector::ZeroVector;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics)
+	FVector Target = FVector::ZeroVector;
+	//Target velocity for leading, assumed constant during the flight.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics)
+	FVector TargetVelocity = FVector::ZeroVector;
+};
+
+USTRUCT(BlueprintType)
+struct FLeviathanBallisticSolution
+{
+	GENERATED_BODY()
+
+	//False if the target can't be reached within MaxFlightTime.
+	UPROPERTY(BlueprintReadOnly, Category = Ballistics)
+	bool bValid = false;
+	//Launch direction, ThrowDirection of the axe.
+	UPROPERTY(BlueprintReadOnly, Category = Ballistics)
+	FVector Direction = FVector::ForwardVector;
+	UPROPERTY(BlueprintReadOnly, Category = Ballistics)
+	float FlightTime = 0.f;
+	//Where the target will be when the axe gets there.
+	UPROPERTY(BlueprintReadOnly, Category = Ballistics)
+	FVector AimPoint = FVector::ZeroVector;
+};
+
+/**Solves the launch direction that makes the axe meet a (moving) target, the direct (earliest) hit.
+ * Requests are split in chunks of LaneCount laid out as structure of arrays, each chunk is solved with branch free
+ * loops over the lanes that the compiler vectorizes, and chunks run in parallel on the task graph workers.
+ */
+struct LEVIATHAN_API FLeviathanBallisticSolver
+{
+	static constexpr int32 LaneCount = 64;
+
+	static void SolveBatch(const FLeviathanBallisticParams& Params, TArrayView<const FLeviathanBallisticRequest> Requests,
+		TArrayView<FLeviathanBallisticSolution> OutSolutions, bool bForceSingleThread = false);
+
+	//Axe position relative to the shooter after Time, for checking solutions.
+	static FVector Simulate(const FLeviathanBallisticParams& Params, const FVector& Direction, float Time);
+
+private:
+	static void SolveChunk(const FLeviathanBallisticParams& Params, const FLeviathanBallisticRequest* Requests,
+		FLeviathanBallisticSolution* OutSolutions, int32 Count);
+};
+
+DECLARE_DELEGATE_OneParam(FLeviathanBallisticBatchDone, const TArray<FLeviathanBallisticSolution>& /*Solutions*/);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FLeviathanBallisticSolved, const FLeviathanBallisticSolution&, Solution);
+
+/**Solves throws for AI_Master off the game thread. Everything submitted during a frame is solved as one batch on the
+ * workers and the results are delivered on the next frame.
+ */
+UCLASS()
+class LEVIATHAN_API ULeviathanBallisticsSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	//Flight model used by SolveThrowAsync. Defaults to the ALeviathanAxe class defaults.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics)
+	FLeviathanBallisticParams ThrowParams;
+
+	UFUNCTION(BlueprintCallable, Category = Ballistics)
+	void SetThrowParamsFromAxe(class ALeviathanAxe* Axe);
+
+	//Queues one throw, OnSolved is called next frame.
+	UFUNCTION(BlueprintCallable, Category = Ballistics)
+	void SolveThrowAsync(FVector Shooter, FVector Target, FVector TargetVelocity, FLeviathanBallisticSolved OnSolved);
+
+	//Queues a batch with its own flight model, OnDone is called next frame with one solution per request.
+	void SubmitBatch(const FLeviathanBallisticParams& Params, TArray<FLeviathanBallisticRequest> Requests,
+		FLeviathanBallisticBatchDone OnDone);
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Queued.Num() > 0 || InFlight.Num() > 0 || SingleRequests.Num() > 0; }
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+private:
+	struct FBatch
+	{
+		FLeviathanBallisticParams Params;
+		TArray<FLeviathanBallisticRequest> Requests;
+		TArray<FLeviathanBallisticSolution> Solutions;
+		FLeviathanBallisticBatchDone OnDone;
+	};
+
+	void DispatchQueued();
+	void DeliverInFlight();
+
+	TArray<TSharedPtr<FBatch>> Queued;
+	TArray<TSharedPtr<FBatch>> InFlight;
+	FGraphEventArray InFlightTasks;
+
+	//SolveThrowAsync calls of this frame, they become one batch.
+	TArray<FLeviathanBallisticRequest> SingleRequests;
+	TArray<FLeviathanBallisticSolved> SingleCallbacks;
+};
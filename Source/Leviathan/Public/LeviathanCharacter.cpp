@@ -2,8 +2,16 @@
 
 #include "LeviathanCharacter.h"
 
+#include "Leviathan.h"
 
+#include "LeviathanAimCameraComponent.h"
 #include "LeviathanAxe.h"
+#include "LeviathanInputHistoryComponent.h"
+#include "LeviathanMemory.h"
+#include "LeviathanPerfBudget.h"
+#include "LeviathanSocketCacheComponent.h"
+#include "LeviathanTrajectoryPreviewComponent.h"
+#include "LeviathanTrace.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
@@ -11,11 +19,26 @@
 #include "GameFramework/Controller.h"
 #include "GameFramework/SpringArmComponent.h"
 
+DECLARE_CYCLE_STAT(TEXT("Character Aim"), STAT_CharacterAim, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Character LerpCameraPosition"), STAT_CharacterLerpCameraPosition, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Character CatchAxe"), STAT_CharacterCatchAxe, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Character TurnAtRate"), STAT_CharacterTurnAtRate, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Character LookUpAtRate"), STAT_CharacterLookUpAtRate, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Character MoveForward"), STAT_CharacterMoveForward, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Character MoveRight"), STAT_CharacterMoveRight, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Character BeginPlay"), STAT_CharacterBeginPlay, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Character SetupPlayerInputComponent"), STAT_CharacterSetupPlayerInputComponent,
+	STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Character ApplyCameraBlend"), STAT_CharacterApplyCameraBlend, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Character CanThrowAxe"), STAT_CharacterCanThrowAxe, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Character CanRecallAxe"), STAT_CharacterCanRecallAxe, STATGROUP_Leviathan);
+
 //////////////////////////////////////////////////////////////////////////
 // ALeviathanCharacter
 
 ALeviathanCharacter::ALeviathanCharacter()
 {
+	LEVIATHAN_LLM_SCOPE(Character);
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
 	IdleCameraVector = FVector(10.0f,95.0f,20.0f);
@@ -46,6 +69,15 @@ ALeviathanCharacter::ALeviathanCharacter()
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
+	//Blends the boom between idle and aim when Aim() is called.
+	AimCamera = CreateDefaultSubobject<ULeviathanAimCameraComponent>(TEXT("AimCamera"));
+	//Predicts where the axe will land while aiming.
+	TrajectoryPreview = CreateDefaultSubobject<ULeviathanTrajectoryPreviewComponent>(TEXT("TrajectoryPreview"));
+	//Remembers when throw was pressed and where the camera was.
+	InputHistory = CreateDefaultSubobject<ULeviathanInputHistoryComponent>(TEXT("InputHistory"));
+	//Socket transforms the returning axe reads every frame.
+	SocketCache = CreateDefaultSubobject<ULeviathanSocketCacheComponent>(TEXT("SocketCache"));
+
 	//Create a child component for the axe.
 	LeviathanAxeChildActorComponent = CreateDefaultSubobject<UChildActorComponent>(TEXT("LeviathanAxe"));
 	LeviathanAxeChildActorComponent->SetupAttachment(GetMesh());
@@ -59,6 +91,8 @@ ALeviathanCharacter::ALeviathanCharacter()
 
 void ALeviathanCharacter::BeginPlay()
 {
+	SCOPE_CYCLE_COUNTER(STAT_CharacterBeginPlay);
+	LEVIATHAN_LLM_SCOPE(Character);
 	//Calls Parents Begin Play
 	Super::BeginPlay();
 	//Setup begin play here
@@ -78,6 +112,7 @@ void ALeviathanCharacter::BeginPlay()
 
 void ALeviathanCharacter::SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent)
 {
+	SCOPE_CYCLE_COUNTER(STAT_CharacterSetupPlayerInputComponent);
 	// Set up gameplay key bindings
 	check(PlayerInputComponent);
 
@@ -100,6 +135,7 @@ void ALeviathanCharacter::SetupPlayerInputComponent(class UInputComponent* Playe
 
 void ALeviathanCharacter::Aim()
 {
+	SCOPE_CYCLE_COUNTER(STAT_CharacterAim);
 	//If the value is 1 it means player is aiming, else its released.
 	if(bAiming)
 	{
@@ -130,42 +166,69 @@ void ALeviathanCharacter::Aim()
 		GetCharacterMovement()->MaxWalkSpeed = IdleWalkSpeed;
 
 	}
+	AimCamera->SetAiming(bAiming);
+	TrajectoryPreview->SetPreviewActive(bAiming);
+	InputHistory->SetRecording(bAiming);
+	OnAimChanged.Broadcast(this, bAiming);
 	
 	
 }
 
 void ALeviathanCharacter::LerpCameraPosition(float LerpCurve)
 {
-	CameraBoom->TargetArmLength = FMath::Lerp(IdleSpringArmLength,AimSpringArmLength,LerpCurve);
-	LerpedSocketOffset = FMath::Lerp(IdleCameraVector,AimCameraVector,LerpCurve);
-	CameraBoom->SocketOffset = LerpedSocketOffset;
+	SCOPE_CYCLE_COUNTER(STAT_CharacterLerpCameraPosition);
+	//The native spring blend owns the camera, ignore the old timeline.
+	if(AimCamera->bDriveCamera)
+	{
+		return;
+	}
+	ApplyCameraBlend(LerpCurve);
 	
 }
 
+void ALeviathanCharacter::ApplyCameraBlend(float Alpha)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CharacterApplyCameraBlend);
+	CameraBoom->TargetArmLength = FMath::Lerp(IdleSpringArmLength,AimSpringArmLength,Alpha);
+	LerpedSocketOffset = FMath::Lerp(IdleCameraVector,AimCameraVector,Alpha);
+	CameraBoom->SocketOffset = LerpedSocketOffset;
+}
+
 void ALeviathanCharacter::CatchAxe(AActor *Axe)
 {
+	SCOPE_CYCLE_COUNTER(STAT_CharacterCatchAxe);
+	LEVIATHAN_PERF_SCOPE(CatchAxe);
 	Axe->AttachToComponent(GetMesh(),FAttachmentTransformRules::SnapToTargetIncludingScale,TEXT("RightHandWeaponBoneSocket"));
 	bAxeThrown = false;
 	bAxeRecalled = false;
-	Cast<ALeviathanAxe>(Axe)->AxeState = EAxeState::Idle;
+	ALeviathanAxe* LeviathanAxe = Cast<ALeviathanAxe>(Axe);
+	LeviathanAxe->AxeState = EAxeState::Idle;
+
+	TRACE_LEVIATHAN_AXE_EVENT(Catch, Axe, float((FPlatformTime::Seconds() - LeviathanAxe->RecallTimeSeconds) * 1000.0),
+		0.f, SurfaceType_Default);
+	LeviathanAxe->RecordTelemetry(ELeviathanAxeTraceEvent::Catch);
+	LeviathanAxe->OnAxeEvent.Broadcast(LeviathanAxe, ELeviathanAxeTraceEvent::Catch);
 	
 }
 
 
 void ALeviathanCharacter::TurnAtRate(float Rate)
 {
+	SCOPE_CYCLE_COUNTER(STAT_CharacterTurnAtRate);
 	// calculate delta for this frame from the rate information
 	AddControllerYawInput(Rate * BaseTurnRate * GetWorld()->GetDeltaSeconds());
 }
 
 void ALeviathanCharacter::LookUpAtRate(float Rate)
 {
+	SCOPE_CYCLE_COUNTER(STAT_CharacterLookUpAtRate);
 	// calculate delta for this frame from the rate information
 	AddControllerPitchInput(Rate * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
 }
 
 void ALeviathanCharacter::MoveForward(float Value)
 {
+	SCOPE_CYCLE_COUNTER(STAT_CharacterMoveForward);
 	if ((Controller != NULL) && (Value != 0.0f))
 	{
 		// find out which way is forward
@@ -180,6 +243,7 @@ void ALeviathanCharacter::MoveForward(float Value)
 
 void ALeviathanCharacter::MoveRight(float Value)
 {
+	SCOPE_CYCLE_COUNTER(STAT_CharacterMoveRight);
 	if ( (Controller != NULL) && (Value != 0.0f) )
 	{
 		// find out which way is right
@@ -195,6 +259,7 @@ void ALeviathanCharacter::MoveRight(float Value)
 
 bool ALeviathanCharacter::CanThrowAxe() const
 {
+	SCOPE_CYCLE_COUNTER(STAT_CharacterCanThrowAxe);
 	 if(bAiming&&!bAxeThrown)
 	 	return true;
 	return false;
@@ -202,6 +267,7 @@ bool ALeviathanCharacter::CanThrowAxe() const
 
 bool ALeviathanCharacter::CanRecallAxe() const
 {
+	SCOPE_CYCLE_COUNTER(STAT_CharacterCanRecallAxe);
 	if(bAxeThrown&&!bAxeRecalled)
 		return true;
 	return false;
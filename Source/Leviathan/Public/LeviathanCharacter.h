@@ -9,6 +9,9 @@
 #include "GameFramework/Character.h"
 #include "LeviathanCharacter.generated.h"
 
+//Aim pressed or released, broadcast by Aim.
+DECLARE_MULTICAST_DELEGATE_TwoParams(FLeviathanAimChanged, class ALeviathanCharacter* /*Character*/, bool /*bAiming*/);
+
 UCLASS(config=Game, Blueprintable)
 class ALeviathanCharacter : public ACharacter
 {
@@ -29,6 +32,18 @@ public:
     	/** Follow camera */
     	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
     	class UCameraComponent* FollowCamera;
+	/** Native aim/idle camera blend */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
+	class ULeviathanAimCameraComponent* AimCamera;
+	/** Predicted lodge point while aiming, for the HUD */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
+	class ULeviathanTrajectoryPreviewComponent* TrajectoryPreview;
+	/** Input press times and camera pose history, so the throw uses the camera at the press */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
+	class ULeviathanInputHistoryComponent* InputHistory;
+	/** AxeSocket and hand socket transforms, snapshotted once per frame after animation */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Axe, meta = (AllowPrivateAccess = "true"))
+	class ULeviathanSocketCacheComponent* SocketCache;
 	/** Axe Child Object */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Axe)
 	class UChildActorComponent* LeviathanAxeChildActorComponent;
@@ -105,11 +120,13 @@ protected:
 	UFUNCTION(BlueprintCallable, Category = AxeAim)
 	void Aim();
 	
+	//Kept for the Blueprint timeline, does nothing while AimCamera drives the camera.
 	UFUNCTION(BlueprintCallable, Category = AxeAim)
 	void LerpCameraPosition(float LerpCurve);
 	
 #pragma endregion
 
+public:
 	UFUNCTION(BlueprintCallable, Category = CatchAxe)
     void CatchAxe(AActor *Axe);
 	
@@ -137,8 +154,13 @@ public:
 	//Boolean to keep track to see if the player has called recall axe
 	UPROPERTY(BlueprintReadWrite,Category = "AxeThrow")
 	bool bAxeRecalled = false;
+
+	//Aim start and stop, for the HUD. The axe events are on ALeviathanAxe::OnAxeEvent.
+	FLeviathanAimChanged OnAimChanged;
 	
 #pragma region Camera Components
+	//Sets the boom between the idle (0) and aim (1) camera.
+	void ApplyCameraBlend(float Alpha);
 	/** Returns CameraBoom subobject **/
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
@@ -0,0 +1,274 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanDestructibleManager.h"
+
+#include "Leviathan.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Parse.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_CYCLE_STAT(TEXT("Destructible Break"), STAT_DestructibleBreak, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Destructible Tick"), STAT_DestructibleTick, STATGROUP_Leviathan);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Destructible Active Breaks"), STAT_DestructibleActiveBreaks, STATGROUP_Leviathan);
+
+ALeviathanDestructibleManager::ALeviathanDestructibleManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	//Only ticks while there are broken props waiting to go back to the pool.
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	IntactProps = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("IntactProps"));
+	RootComponent = IntactProps;
+	IntactProps->SetMobility(EComponentMobility::Static);
+	IntactProps->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	IntactProps->SetCanEverAffectNavigation(false);
+}
+
+void ALeviathanDestructibleManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//Spawn everything up front so breaking never spawns an actor mid combat.
+	for(int32 Index = 0; Index < PoolSize; Index++)
+	{
+		if(!AddToPool())
+		{
+			break;
+		}
+	}
+}
+
+void ALeviathanDestructibleManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	for(FLeviathanPooledBreak& Break : Pool)
+	{
+		if(Break.Actor)
+		{
+			Break.Actor->Destroy();
+		}
+	}
+	Pool.Reset();
+	FreePool.Reset();
+	ActiveBreaks.Reset();
+	Super::EndPlay(EndPlayReason);
+}
+
+bool ALeviathanDestructibleManager::AddToPool()
+{
+	if(!FracturedClass)
+	{
+		return false;
+	}
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.Owner = this;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AActor* Actor = GetWorld()->SpawnActor<AActor>(FracturedClass, GetActorTransform(), SpawnParameters);
+	if(!Actor)
+	{
+		return false;
+	}
+
+	FLeviathanPooledBreak& Break = Pool.AddDefaulted_GetRef();
+	Break.Actor = Actor;
+	Actor->GetComponents<UPrimitiveComponent>(Break.Pieces);
+	for(UPrimitiveComponent* Piece : Break.Pieces)
+	{
+		//Pooled pieces are moved and simulated, a Static piece would warn on every move.
+		Piece->SetMobility(EComponentMobility::Movable);
+		//Debris is not something the axe lodges in, the lodge trace is on ECC_Visibility.
+		Piece->SetCollisionResponseToChannel(ECC_Visibility, ECR_Ignore);
+		Break.PieceTransforms.Add(Piece->GetRelativeTransform());
+	}
+	ReturnToPool(Pool.Num() - 1);
+	return true;
+}
+
+int32 ALeviathanDestructibleManager::AddProp(const FTransform& WorldTransform)
+{
+	return IntactProps->AddInstanceWorldSpace(WorldTransform);
+}
+
+bool ALeviathanDestructibleManager::BreakInstance(int32 InstanceIndex, FVector ImpactDirection)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DestructibleBreak);
+
+	FTransform InstanceTransform;
+	if(!IntactProps->GetInstanceTransform(InstanceIndex, InstanceTransform, true))
+	{
+		return false;
+	}
+	IntactProps->RemoveInstance(InstanceIndex);
+
+	if(FreePool.Num() == 0 && ActiveBreaks.Num() > 0)
+	{
+		//Pool is exhausted, take the oldest break back.
+		ReturnToPool(ActiveBreaks[0].PoolIndex);
+		ActiveBreaks.RemoveAt(0, 1, false);
+		DEC_DWORD_STAT(STAT_DestructibleActiveBreaks);
+	}
+	if(FreePool.Num() > 0)
+	{
+		ActivateBreak(FreePool.Pop(false), InstanceTransform, ImpactDirection);
+	}
+
+	if(BreakSound)
+	{
+		UGameplayStatics::SpawnSoundAtLocation(GetWorld(), BreakSound, InstanceTransform.GetLocation(),
+			FRotator::ZeroRotator, 1.f, 1.f, 0.f, BreakAttenuation);
+	}
+	return true;
+}
+
+bool ALeviathanDestructibleManager::TryBreakFromHit(const FHitResult& Hit, const FVector& ImpactDirection)
+{
+	UHierarchicalInstancedStaticMeshComponent* HitComponent =
+		Cast<UHierarchicalInstancedStaticMeshComponent>(Hit.GetComponent());
+	ALeviathanDestructibleManager* Manager = HitComponent ?
+		Cast<ALeviathanDestructibleManager>(HitComponent->GetOwner()) : nullptr;
+	if(!Manager || HitComponent != Manager->IntactProps || Hit.Item == INDEX_NONE)
+	{
+		return false;
+	}
+	return Manager->BreakInstance(Hit.Item, ImpactDirection);
+}
+
+void ALeviathanDestructibleManager::ActivateBreak(int32 PoolIndex, const FTransform& Transform,
+	const FVector& ImpactDirection)
+{
+	FLeviathanPooledBreak& Break = Pool[PoolIndex];
+	Break.Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+	Break.Actor->SetActorHiddenInGame(false);
+	Break.Actor->SetActorEnableCollision(true);
+
+	const FVector Impulse = ImpactDirection.GetSafeNormal() * BreakImpulse;
+	for(UPrimitiveComponent* Piece : Break.Pieces)
+	{
+		Piece->SetSimulatePhysics(true);
+		Piece->AddImpulse(Impulse, NAME_None, true);
+	}
+
+	FActiveBreak& Active = ActiveBreaks.AddDefaulted_GetRef();
+	Active.PoolIndex = PoolIndex;
+	INC_DWORD_STAT(STAT_DestructibleActiveBreaks);
+	SetActorTickEnabled(true);
+}
+
+void ALeviathanDestructibleManager::ReturnToPool(int32 PoolIndex)
+{
+	FLeviathanPooledBreak& Break = Pool[PoolIndex];
+	for(int32 PieceIndex = 0; PieceIndex < Break.Pieces.Num(); PieceIndex++)
+	{
+		UPrimitiveComponent* Piece = Break.Pieces[PieceIndex];
+		Piece->SetSimulatePhysics(false);
+		//Simulating detaches the pieces, put them back where they were in the fractured actor.
+		if(Piece != Break.Actor->GetRootComponent())
+		{
+			Piece->AttachToComponent(Break.Actor->GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+		}
+		Piece->SetRelativeTransform(Break.PieceTransforms[PieceIndex], false, nullptr, ETeleportType::ResetPhysics);
+	}
+	Break.Actor->SetActorHiddenInGame(true);
+	Break.Actor->SetActorEnableCollision(false);
+	FreePool.Add(PoolIndex);
+}
+
+bool ALeviathanDestructibleManager::IsAsleep(const FLeviathanPooledBreak& Break) const
+{
+	for(const UPrimitiveComponent* Piece : Break.Pieces)
+	{
+		if(Piece->IsSimulatingPhysics() && Piece->RigidBodyIsAwake())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void ALeviathanDestructibleManager::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DestructibleTick);
+	Super::Tick(DeltaTime);
+
+	for(int32 Index = ActiveBreaks.Num() - 1; Index >= 0; Index--)
+	{
+		FActiveBreak& Active = ActiveBreaks[Index];
+		Active.Age += DeltaTime;
+		if(Active.Age >= MaxBreakLifetime || (Active.Age >= MinBreakLifetime && IsAsleep(Pool[Active.PoolIndex])))
+		{
+			ReturnToPool(Active.PoolIndex);
+			ActiveBreaks.RemoveAt(Index, 1, false);
+			DEC_DWORD_STAT(STAT_DestructibleActiveBreaks);
+		}
+	}
+	if(ActiveBreaks.Num() == 0)
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+/**Leviathan.Destructibles.Bench [Props=1000] [Breaks=50]
+ * Fills a transient manager with cubes and breaks a batch of them in the same frame, logging the cost of each step.
+ * The manager and its pool are destroyed when it is done.*/
+static FAutoConsoleCommandWithWorldAndArgs DestructiblesBenchCommand(
+	TEXT("Leviathan.Destructibles.Bench"),
+	TEXT("Spawns Props intact instances and breaks Breaks of them at once. Props=1000 Breaks=50 by default."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if(!World)
+		{
+			return;
+		}
+		int32 NumProps = 1000;
+		int32 NumBreaks = 50;
+		for(const FString& Arg : Args)
+		{
+			FParse::Value(*Arg, TEXT("Props="), NumProps);
+			FParse::Value(*Arg, TEXT("Breaks="), NumBreaks);
+		}
+		NumBreaks = FMath::Min(NumBreaks, NumProps);
+
+		UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.bDeferConstruction = true;
+		ALeviathanDestructibleManager* Manager = World->SpawnActor<ALeviathanDestructibleManager>(SpawnParameters);
+		Manager->FracturedClass = AStaticMeshActor::StaticClass();
+		Manager->PoolSize = NumBreaks;
+		Manager->IntactProps->SetMobility(EComponentMobility::Movable);
+		Manager->IntactProps->SetStaticMesh(Cube);
+
+		double StartTime = FPlatformTime::Seconds();
+		Manager->FinishSpawning(FTransform::Identity);
+		for(const FLeviathanPooledBreak& Break : Manager->GetPool())
+		{
+			CastChecked<AStaticMeshActor>(Break.Actor)->GetStaticMeshComponent()->SetStaticMesh(Cube);
+		}
+		const double PoolMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		StartTime = FPlatformTime::Seconds();
+		const int32 Side = FMath::CeilToInt(FMath::Sqrt(float(NumProps)));
+		for(int32 Index = 0; Index < NumProps; Index++)
+		{
+			Manager->AddProp(FTransform(FVector((Index % Side) * 150.f, (Index / Side) * 150.f, 5000.f)));
+		}
+		const double AddMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		StartTime = FPlatformTime::Seconds();
+		for(int32 Index = 0; Index < NumBreaks; Index++)
+		{
+			//Break from the end so the remaining indexes stay valid.
+			Manager->BreakInstance(Manager->IntactProps->GetInstanceCount() - 1, FVector::ForwardVector);
+		}
+		const double BreakMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		UE_LOG(LogLeviathan, Display, TEXT("Destructibles bench: pool of %d in %.3f ms, %d props in %.3f ms, ")
+			TEXT("%d breaks in %.3f ms (%.4f ms per break), %d active"), NumBreaks, PoolMs, NumProps, AddMs, NumBreaks,
+			BreakMs, NumBreaks > 0 ? BreakMs / NumBreaks : 0.0, Manager->GetActiveBreakCount());
+		//EndPlay destroys the pool with it.
+		Manager->Destroy();
+	}));
+#endif
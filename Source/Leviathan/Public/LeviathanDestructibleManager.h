@@ -0,0 +1,107 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+
+#include "LeviathanDestructibleManager.generated.h"
+
+//A fractured actor owned by the pool.
+USTRUCT()
+struct FLeviathanPooledBreak
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AActor* Actor = nullptr;
+	//Every primitive of the actor, simulated on break.
+	UPROPERTY()
+	TArray<class UPrimitiveComponent*> Pieces;
+	//Relative transforms of the pieces when spawned, restored when going back to the pool.
+	TArray<FTransform> PieceTransforms;
+};
+
+/**Renders every intact breakable prop of one kind (pots...) as instances of a single hierarchical instanced static mesh.
+ * When the axe hits an instance it is removed and a pooled pre-fractured actor is dropped in its place. The fractured
+ * actor goes back to the pool once all its pieces are asleep (or MaxBreakLifetime is reached).
+ * Use one manager per prop type, place instances in the editor or with AddProp.
+ */
+UCLASS()
+class LEVIATHAN_API ALeviathanDestructibleManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ALeviathanDestructibleManager();
+
+	//All the intact props. Give the mesh simple collision, it blocks Visibility so the axe trace can hit it.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Destructible)
+	class UHierarchicalInstancedStaticMeshComponent* IntactProps;
+
+	//Pre-fractured version of the prop (chunks or a geometry collection). Every primitive in it is simulated on break.
+	//The pool makes the primitives Movable and ignore Visibility, so the axe flies through the debris.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Destructible)
+	TSubclassOf<AActor> FracturedClass;
+
+	//Fractured actors spawned up front. Breaking with an empty pool recycles the oldest break.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Destructible, meta = (ClampMin = "1"))
+	int32 PoolSize = 50;
+
+	//Impulse applied to the pieces, along the axe direction.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Destructible)
+	float BreakImpulse = 300.f;
+
+	//Seconds before a break can go back to the pool, even if the pieces fell asleep straight away.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Destructible)
+	float MinBreakLifetime = 1.f;
+
+	//Seconds after which a break goes back to the pool even if pieces are still moving.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Destructible)
+	float MaxBreakLifetime = 10.f;
+
+	//Played on break (PotBreak_Cue for the pots).
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Destructible)
+	class USoundBase* BreakSound;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Destructible)
+	class USoundAttenuation* BreakAttenuation;
+
+	UFUNCTION(BlueprintCallable, Category = Destructible)
+	int32 AddProp(const FTransform& WorldTransform);
+
+	//Swaps the instance for a fractured actor. Returns false if the index is not valid.
+	UFUNCTION(BlueprintCallable, Category = Destructible)
+	bool BreakInstance(int32 InstanceIndex, FVector ImpactDirection);
+
+	/**Breaks the prop if the hit is on an intact instance of a manager.
+	 * @return true if something was broken*/
+	static bool TryBreakFromHit(const FHitResult& Hit, const FVector& ImpactDirection);
+
+	int32 GetActiveBreakCount() const { return ActiveBreaks.Num(); }
+	int32 GetFreePoolCount() const { return FreePool.Num(); }
+	const TArray<FLeviathanPooledBreak>& GetPool() const { return Pool; }
+
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	struct FActiveBreak
+	{
+		int32 PoolIndex = INDEX_NONE;
+		float Age = 0.f;
+	};
+
+	bool AddToPool();
+	void ActivateBreak(int32 PoolIndex, const FTransform& Transform, const FVector& ImpactDirection);
+	void ReturnToPool(int32 PoolIndex);
+	bool IsAsleep(const FLeviathanPooledBreak& Break) const;
+
+	//Every fractured actor spawned, the free list and active breaks are indexes into this.
+	UPROPERTY(Transient)
+	TArray<FLeviathanPooledBreak> Pool;
+	TArray<int32> FreePool;
+	TArray<FActiveBreak> ActiveBreaks;
+};
@@ -0,0 +1,411 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanFlightRecorderComponent.h"
+
+#include "Leviathan.h"
+#include "LeviathanMemory.h"
+#include "LeviathanPerfBudget.h"
+#include "Algo/BinarySearch.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Parse.h"
+
+DECLARE_CYCLE_STAT(TEXT("FlightRecorder Record"), STAT_FlightRecorderRecord, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("FlightRecorder Decode"), STAT_FlightRecorderDecode, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("FlightRecorder Replay"), STAT_FlightRecorderReplay, STATGROUP_Leviathan);
+
+//Frame layout: flags, milliseconds since the previous frame (varint), then the parts the flags say are present.
+//Location is in LocationScale units: absolute on keyframes, else the error against Previous + Velocity.
+//Rotation is three compressed shorts, absolute on keyframes, else signed deltas. Spin and state are absolute bytes.
+enum EFlightFrameFlags : uint8
+{
+	FlightFrame_Key = 1 << 0,
+	FlightFrame_Location = 1 << 1,
+	FlightFrame_Rotation = 1 << 2,
+	FlightFrame_Spin = 1 << 3,
+	FlightFrame_State = 1 << 4,
+};
+//Half a unit of precision is plenty for a replay camera.
+static constexpr float LocationScale = 2.f;
+//Worst case frame: flags, time, 3 x 5 byte location, 3 x 3 byte rotation, spin, state.
+static constexpr int32 MaxFrameBytes = 1 + 5 + 15 + 9 + 1 + 1;
+
+static uint32 ZigZag(int32 Value) { return (uint32(Value) << 1) ^ uint32(Value >> 31); }
+static int32 UnZigZag(uint32 Value) { return int32(Value >> 1) ^ -int32(Value & 1); }
+
+static void WriteVarInt(TArray<uint8>& Bytes, uint32 Value)
+{
+	while(Value >= 0x80)
+	{
+		Bytes.Add(uint8(Value | 0x80));
+		Value >>= 7;
+	}
+	Bytes.Add(uint8(Value));
+}
+
+static uint32 ReadVarInt(const TArray<uint8>& Bytes, int32& Offset)
+{
+	uint32 Value = 0;
+	for(int32 Shift = 0; Offset < Bytes.Num() && Shift < 35; Shift += 7)
+	{
+		const uint8 Byte = Bytes[Offset++];
+		Value |= uint32(Byte & 0x7F) << Shift;
+		if(!(Byte & 0x80))
+		{
+			break;
+		}
+	}
+	return Value;
+}
+
+static FIntVector QuantizeLocation(const FVector& Location)
+{
+	return FIntVector(FMath::RoundToInt(Location.X * LocationScale), FMath::RoundToInt(Location.Y * LocationScale),
+		FMath::RoundToInt(Location.Z * LocationScale));
+}
+
+ULeviathanFlightRecorderComponent::ULeviathanFlightRecorderComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	//After the timelines and movement moved the axe this frame.
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+}
+
+void ULeviathanFlightRecorderComponent::BeginPlay()
+{
+	LEVIATHAN_LLM_SCOPE(Axe);
+	Super::BeginPlay();
+
+	Blocks.SetNum(FMath::CeilToInt(RecordSeconds / BlockSeconds) + 1);
+	for(FBlock& Block : Blocks)
+	{
+		Block.Bytes.Reserve(BlockBytes);
+	}
+}
+
+ULeviathanFlightRecorderComponent::FBlock& ULeviathanFlightRecorderComponent::StartBlock(double Time)
+{
+	if(BlockCount == Blocks.Num())
+	{
+		//Full, the oldest block goes.
+		BlockHead = (BlockHead + 1) % Blocks.Num();
+		BlockCount--;
+	}
+	FBlock& Block = Blocks[(BlockHead + BlockCount) % Blocks.Num()];
+	BlockCount++;
+	//Reset keeps the allocation from BeginPlay.
+	Block.Bytes.Reset();
+	Block.StartTime = Time;
+	Block.EndTime = Time;
+	return Block;
+}
+
+void ULeviathanFlightRecorderComponent::TickComponent(float DeltaTime, ELevelTick TickType,
+	FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if(IsReplaying())
+	{
+		TickReplay(DeltaTime);
+	}
+
+	const ALeviathanAxe* Axe = Cast<ALeviathanAxe>(GetOwner());
+	if(!bRecording || !Axe || Blocks.Num() == 0)
+	{
+		return;
+	}
+	//Keep recording the frame the axe gets back to the hand, then stop until the next throw.
+	const bool bIdle = Axe->AxeState == EAxeState::Idle;
+	const double Now = GetWorld()->GetTimeSeconds();
+	if((bIdle && bWasIdle) || (BlockCount > 0 && Now - LastFrame.Time < MinSampleInterval))
+	{
+		return;
+	}
+	bWasIdle = bIdle;
+
+	FLeviathanFlightSample Sample;
+	Sample.Time = Now;
+	Sample.Location = Axe->GetActorLocation();
+	Sample.Rotation = Axe->GetActorRotation();
+	Sample.SpinPitch = Axe->CenterPoint->GetRelativeRotation().Pitch;
+	Sample.State = Axe->AxeState;
+	Record(Sample);
+}
+
+void ULeviathanFlightRecorderComponent::Record(const FLeviathanFlightSample& Sample)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlightRecorderRecord);
+	LEVIATHAN_PERF_SCOPE(RecordFlight);
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	FBlock* Block = BlockCount > 0 ? &Blocks[(BlockHead + BlockCount - 1) % Blocks.Num()] : nullptr;
+	const bool bKey = !Block || Block->Bytes.Num() + MaxFrameBytes > BlockBytes
+		|| Sample.Time - Block->StartTime >= BlockSeconds;
+	if(bKey)
+	{
+		Block = &StartBlock(Sample.Time);
+	}
+
+	const FIntVector Location = QuantizeLocation(Sample.Location);
+	const uint16 Rotation[3] = { FRotator::CompressAxisToShort(Sample.Rotation.Pitch),
+		FRotator::CompressAxisToShort(Sample.Rotation.Yaw), FRotator::CompressAxisToShort(Sample.Rotation.Roll) };
+	const uint8 Spin = FRotator::CompressAxisToByte(Sample.SpinPitch);
+	const uint8 State = uint8(Sample.State);
+
+	//Time is stored in whole milliseconds and rebuilt the same way, so it never drifts from the decoder.
+	const uint32 DeltaMs = bKey ? 0 : uint32(FMath::Max(FMath::RoundToInt((Sample.Time - LastFrame.Time) * 1000.0), 0));
+	const FIntVector Residual = bKey ? Location : Location - (LastFrame.Location + LastFrame.Velocity);
+	const bool bRotationChanged = bKey || FMemory::Memcmp(Rotation, LastFrame.Rotation, sizeof(Rotation)) != 0;
+
+	uint8 Flags = 0;
+	Flags |= bKey ? FlightFrame_Key : 0;
+	Flags |= (bKey || Residual != FIntVector::ZeroValue) ? FlightFrame_Location : 0;
+	Flags |= bRotationChanged ? FlightFrame_Rotation : 0;
+	Flags |= (bKey || Spin != LastFrame.Spin) ? FlightFrame_Spin : 0;
+	Flags |= (bKey || State != LastFrame.State) ? FlightFrame_State : 0;
+
+	TArray<uint8>& Bytes = Block->Bytes;
+	Bytes.Add(Flags);
+	WriteVarInt(Bytes, DeltaMs);
+	if(Flags & FlightFrame_Location)
+	{
+		WriteVarInt(Bytes, ZigZag(Residual.X));
+		WriteVarInt(Bytes, ZigZag(Residual.Y));
+		WriteVarInt(Bytes, ZigZag(Residual.Z));
+	}
+	if(Flags & FlightFrame_Rotation)
+	{
+		for(int32 Axis = 0; Axis < 3; Axis++)
+		{
+			WriteVarInt(Bytes, bKey ? Rotation[Axis] : ZigZag(int16(Rotation[Axis] - LastFrame.Rotation[Axis])));
+		}
+	}
+	if(Flags & FlightFrame_Spin)
+	{
+		Bytes.Add(Spin);
+	}
+	if(Flags & FlightFrame_State)
+	{
+		Bytes.Add(State);
+	}
+
+	LastFrame.Time = bKey ? Sample.Time : LastFrame.Time + DeltaMs / 1000.0;
+	LastFrame.Velocity = bKey ? FIntVector::ZeroValue : Location - LastFrame.Location;
+	LastFrame.Location = Location;
+	FMemory::Memcpy(LastFrame.Rotation, Rotation, sizeof(Rotation));
+	LastFrame.Spin = Spin;
+	LastFrame.State = State;
+	Block->EndTime = LastFrame.Time;
+
+	RecordMsTotal += FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	RecordCalls++;
+}
+
+void ULeviathanFlightRecorderComponent::Decode(TArray<FLeviathanFlightSample>& OutSamples) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlightRecorderDecode);
+	OutSamples.Reset();
+
+	for(int32 BlockIndex = 0; BlockIndex < BlockCount; BlockIndex++)
+	{
+		const FBlock& Block = Blocks[(BlockHead + BlockIndex) % Blocks.Num()];
+		const TArray<uint8>& Bytes = Block.Bytes;
+		FEncodedFrame Frame;
+		Frame.Time = Block.StartTime;
+		int32 Offset = 0;
+		while(Offset < Bytes.Num())
+		{
+			const uint8 Flags = Bytes[Offset++];
+			const bool bKey = (Flags & FlightFrame_Key) != 0;
+			Frame.Time += ReadVarInt(Bytes, Offset) / 1000.0;
+
+			FIntVector Location = bKey ? FIntVector::ZeroValue : Frame.Location + Frame.Velocity;
+			if(Flags & FlightFrame_Location)
+			{
+				Location.X += UnZigZag(ReadVarInt(Bytes, Offset));
+				Location.Y += UnZigZag(ReadVarInt(Bytes, Offset));
+				Location.Z += UnZigZag(ReadVarInt(Bytes, Offset));
+			}
+			Frame.Velocity = bKey ? FIntVector::ZeroValue : Location - Frame.Location;
+			Frame.Location = Location;
+			if(Flags & FlightFrame_Rotation)
+			{
+				for(int32 Axis = 0; Axis < 3; Axis++)
+				{
+					const uint32 Value = ReadVarInt(Bytes, Offset);
+					Frame.Rotation[Axis] = bKey ? uint16(Value) : uint16(Frame.Rotation[Axis] + UnZigZag(Value));
+				}
+			}
+			if((Flags & FlightFrame_Spin) && Offset < Bytes.Num())
+			{
+				Frame.Spin = Bytes[Offset++];
+			}
+			if((Flags & FlightFrame_State) && Offset < Bytes.Num())
+			{
+				Frame.State = Bytes[Offset++];
+			}
+
+			FLeviathanFlightSample& Sample = OutSamples.AddDefaulted_GetRef();
+			Sample.Time = Frame.Time;
+			Sample.Location = FVector(Frame.Location) / LocationScale;
+			Sample.Rotation = FRotator(FRotator::DecompressAxisFromShort(Frame.Rotation[0]),
+				FRotator::DecompressAxisFromShort(Frame.Rotation[1]), FRotator::DecompressAxisFromShort(Frame.Rotation[2]));
+			Sample.SpinPitch = FRotator::DecompressAxisFromByte(Frame.Spin);
+			Sample.State = EAxeState(Frame.State);
+		}
+	}
+}
+
+int32 ULeviathanFlightRecorderComponent::GetUsedBytes() const
+{
+	int32 Used = 0;
+	for(int32 BlockIndex = 0; BlockIndex < BlockCount; BlockIndex++)
+	{
+		Used += Blocks[(BlockHead + BlockIndex) % Blocks.Num()].Bytes.Num();
+	}
+	return Used;
+}
+
+float ULeviathanFlightRecorderComponent::GetRecordedSeconds() const
+{
+	if(BlockCount == 0)
+	{
+		return 0.f;
+	}
+	const FBlock& Oldest = Blocks[BlockHead];
+	const FBlock& Newest = Blocks[(BlockHead + BlockCount - 1) % Blocks.Num()];
+	return float(Newest.EndTime - Oldest.StartTime);
+}
+
+bool ULeviathanFlightRecorderComponent::StartReplay(AActor* Proxy, float Seconds, float PlayRate,
+	bool bDestroyProxyWhenDone)
+{
+	StopReplay();
+	if(!Proxy)
+	{
+		return false;
+	}
+	Decode(ReplaySamples);
+	if(ReplaySamples.Num() < 2)
+	{
+		ReplaySamples.Reset();
+		return false;
+	}
+	//The proxy must not record itself.
+	if(ULeviathanFlightRecorderComponent* ProxyRecorder = Proxy->FindComponentByClass<ULeviathanFlightRecorderComponent>())
+	{
+		ProxyRecorder->bRecording = false;
+	}
+	ReplayProxy = Proxy;
+	ReplayRate = PlayRate;
+	bDestroyReplayProxy = bDestroyProxyWhenDone;
+	ReplayTime = FMath::Max(ReplaySamples.Last().Time - Seconds, ReplaySamples[0].Time);
+	return true;
+}
+
+void ULeviathanFlightRecorderComponent::StopReplay()
+{
+	if(bDestroyReplayProxy && ReplayProxy.IsValid())
+	{
+		ReplayProxy->Destroy();
+	}
+	ReplaySamples.Reset();
+	ReplayProxy = nullptr;
+	bDestroyReplayProxy = false;
+}
+
+void ULeviathanFlightRecorderComponent::TickReplay(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlightRecorderReplay);
+	AActor* Proxy = ReplayProxy.Get();
+	ReplayTime += DeltaTime * ReplayRate;
+	if(!Proxy || ReplayTime >= ReplaySamples.Last().Time)
+	{
+		StopReplay();
+		return;
+	}
+
+	//Samples are in time order, the replay only moves forward.
+	const int32 Next = Algo::UpperBoundBy(ReplaySamples, ReplayTime, &FLeviathanFlightSample::Time);
+	const FLeviathanFlightSample& From = ReplaySamples[FMath::Max(Next - 1, 0)];
+	const FLeviathanFlightSample& To = ReplaySamples[FMath::Min(Next, ReplaySamples.Num() - 1)];
+	const float Alpha = To.Time > From.Time ? float((ReplayTime - From.Time) / (To.Time - From.Time)) : 0.f;
+
+	//Jumping between a hand and a lodge would slide the proxy across the level, snap on state changes.
+	const bool bSnap = From.State != To.State;
+	const FVector Location = bSnap ? From.Location : FMath::Lerp(From.Location, To.Location, Alpha);
+	const FQuat Rotation = bSnap ? From.Rotation.Quaternion()
+		: FQuat::Slerp(From.Rotation.Quaternion(), To.Rotation.Quaternion(), Alpha);
+	Proxy->SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+
+	if(ALeviathanAxe* ProxyAxe = Cast<ALeviathanAxe>(Proxy))
+	{
+		const float Spin = From.SpinPitch + FRotator::NormalizeAxis(To.SpinPitch - From.SpinPitch) * Alpha;
+		ProxyAxe->CenterPoint->SetRelativeRotation(FRotator(Spin, 0.f, 0.f));
+		ProxyAxe->AxeState = From.State;
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+static ULeviathanFlightRecorderComponent* FindPlayerAxeRecorder(UWorld* World)
+{
+	for(TActorIterator<ALeviathanAxe> It(World); It; ++It)
+	{
+		if(It->Player && It->FlightRecorder && It->FlightRecorder->bRecording)
+		{
+			return It->FlightRecorder;
+		}
+	}
+	return nullptr;
+}
+
+static FAutoConsoleCommandWithWorld RecorderStatsCommand(
+	TEXT("Leviathan.Recorder.Stats"),
+	TEXT("Logs the memory used by the axe flight recorder, the time it covers and the cost of recording a frame."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		const ULeviathanFlightRecorderComponent* Recorder = World ? FindPlayerAxeRecorder(World) : nullptr;
+		if(!Recorder)
+		{
+			return;
+		}
+		TArray<FLeviathanFlightSample> Samples;
+		Recorder->Decode(Samples);
+		UE_LOG(LogLeviathan, Display, TEXT("Flight recorder: %d frames over %.2f s in %d bytes (%.1f bytes per frame), ")
+			TEXT("%d bytes allocated, %.4f ms per recorded frame"), Samples.Num(), Recorder->GetRecordedSeconds(),
+			Recorder->GetUsedBytes(), Samples.Num() > 0 ? float(Recorder->GetUsedBytes()) / Samples.Num() : 0.f,
+			Recorder->GetCapacityBytes(), Recorder->GetAverageRecordMs());
+	}));
+
+/**Leviathan.Recorder.Replay [Seconds=5] [Rate=1]
+ * Spawns a copy of the axe and plays the last Seconds of the player's axe onto it.*/
+static FAutoConsoleCommandWithWorldAndArgs RecorderReplayCommand(
+	TEXT("Leviathan.Recorder.Replay"),
+	TEXT("Replays the last Seconds of the axe onto a spawned copy. Seconds=5 Rate=1."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		ULeviathanFlightRecorderComponent* Recorder = World ? FindPlayerAxeRecorder(World) : nullptr;
+		if(!Recorder)
+		{
+			return;
+		}
+		float Seconds = 5.f;
+		float Rate = 1.f;
+		for(const FString& Arg : Args)
+		{
+			FParse::Value(*Arg, TEXT("Seconds="), Seconds);
+			FParse::Value(*Arg, TEXT("Rate="), Rate);
+		}
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		AActor* Proxy = World->SpawnActor<AActor>(Recorder->GetOwner()->GetClass(), Recorder->GetOwner()->GetActorTransform(),
+			SpawnParameters);
+		if(Proxy)
+		{
+			Proxy->SetActorEnableCollision(false);
+			Recorder->StartReplay(Proxy, Seconds, Rate, true);
+		}
+	}));
+#endif
@@ -0,0 +1,113 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "LeviathanAxe.h"
+
+#include "LeviathanFlightRecorderComponent.generated.h"
+
+//One decoded frame of the axe.
+struct FLeviathanFlightSample
+{
+	//World time seconds.
+	double Time = 0.0;
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	//Pitch of CenterPoint, the spin of the axe.
+	float SpinPitch = 0.f;
+	EAxeState State = EAxeState::Idle;
+};
+
+/**Keeps the last RecordSeconds of the axe (transform, spin and AxeState) for kill-cams and instant replays, without the
+ * demo net driver. Frames are delta-compressed into a ring of fixed-size blocks allocated up front, each block starting
+ * with a keyframe so the oldest one can be dropped whole. Location is stored as the error against a constant velocity
+ * prediction, rotation, spin and state only when they change, so a flight takes a few bytes per frame.
+ * Nothing is recorded while the axe sits in the hand. Replay onto any actor with StartReplay, an ALeviathanAxe proxy
+ * also gets the spin and AxeState.
+ * Console commands: Leviathan.Recorder.Stats, Leviathan.Recorder.Replay [Seconds=5] [Rate=1]
+ */
+UCLASS(ClassGroup = (Axe), meta = (BlueprintSpawnableComponent))
+class LEVIATHAN_API ULeviathanFlightRecorderComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	ULeviathanFlightRecorderComponent();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Recorder)
+	bool bRecording = true;
+
+	//Seconds kept. Memory is fixed at BeginPlay: one BlockBytes block per BlockSeconds, plus one.
+	UPROPERTY(EditDefaultsOnly, Category = Recorder, meta = (ClampMin = "1"))
+	float RecordSeconds = 10.f;
+	UPROPERTY(EditDefaultsOnly, Category = Recorder, meta = (ClampMin = "0.1"))
+	float BlockSeconds = 1.f;
+	//A block that fills up before BlockSeconds ends early, the ring then covers a bit less time.
+	UPROPERTY(EditDefaultsOnly, Category = Recorder, meta = (ClampMin = "256"))
+	int32 BlockBytes = 1024;
+	//Frames closer than this are not recorded.
+	UPROPERTY(EditDefaultsOnly, Category = Recorder)
+	float MinSampleInterval = 1.f / 60.f;
+
+	//Plays the last Seconds back onto Proxy. Returns false if nothing is recorded.
+	UFUNCTION(BlueprintCallable, Category = Recorder)
+	bool StartReplay(AActor* Proxy, float Seconds = 5.f, float PlayRate = 1.f, bool bDestroyProxyWhenDone = false);
+	UFUNCTION(BlueprintCallable, Category = Recorder)
+	void StopReplay();
+	UFUNCTION(BlueprintPure, Category = Recorder)
+	bool IsReplaying() const { return ReplaySamples.Num() > 0; }
+
+	//Decodes every recorded frame, oldest first.
+	void Decode(TArray<FLeviathanFlightSample>& OutSamples) const;
+	int32 GetUsedBytes() const;
+	int32 GetCapacityBytes() const { return Blocks.Num() * BlockBytes; }
+	float GetRecordedSeconds() const;
+	double GetAverageRecordMs() const { return RecordCalls > 0 ? RecordMsTotal / RecordCalls : 0.0; }
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
+		FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	struct FBlock
+	{
+		double StartTime = 0.0;
+		double EndTime = 0.0;
+		TArray<uint8> Bytes;
+	};
+
+	//Last encoded frame, quantized the same way the decoder rebuilds it.
+	struct FEncodedFrame
+	{
+		double Time = 0.0;
+		FIntVector Location = FIntVector::ZeroValue;
+		FIntVector Velocity = FIntVector::ZeroValue;
+		uint16 Rotation[3] = { 0, 0, 0 };
+		uint8 Spin = 0;
+		uint8 State = 0;
+	};
+
+	void Record(const FLeviathanFlightSample& Sample);
+	FBlock& StartBlock(double Time);
+	void TickReplay(float DeltaTime);
+
+	TArray<FBlock> Blocks;
+	//Oldest block, and how many are in use.
+	int32 BlockHead = 0;
+	int32 BlockCount = 0;
+	FEncodedFrame LastFrame;
+	bool bWasIdle = true;
+
+	TArray<FLeviathanFlightSample> ReplaySamples;
+	TWeakObjectPtr<AActor> ReplayProxy;
+	double ReplayTime = 0.0;
+	float ReplayRate = 1.f;
+	bool bDestroyReplayProxy = false;
+
+	double RecordMsTotal = 0.0;
+	int32 RecordCalls = 0;
+};
@@ -0,0 +1,128 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanHudWidget.h"
+
+#include "Leviathan.h"
+#include "LeviathanAxe.h"
+#include "LeviathanCharacter.h"
+#include "Components/ChildActorComponent.h"
+#include "Components/InvalidationBox.h"
+#include "Components/RetainerBox.h"
+
+DECLARE_CYCLE_STAT(TEXT("HudWidget RefreshState"), STAT_HudWidgetRefreshState, STATGROUP_Leviathan);
+
+void ULeviathanHudWidget::NativeConstruct()
+{
+	Super::NativeConstruct();
+	if(HudCache)
+	{
+		HudCache->SetCanCache(true);
+	}
+	if(!Character.IsValid())
+	{
+		SetCharacter(Cast<ALeviathanCharacter>(GetOwningPlayerPawn()));
+	}
+	else
+	{
+		RefreshState();
+	}
+}
+
+void ULeviathanHudWidget::NativeDestruct()
+{
+	Unbind();
+	Super::NativeDestruct();
+}
+
+void ULeviathanHudWidget::SetCharacter(ALeviathanCharacter* InCharacter)
+{
+	Unbind();
+	Character = InCharacter;
+	if(InCharacter)
+	{
+		AimChangedHandle = InCharacter->OnAimChanged.AddUObject(this, &ULeviathanHudWidget::OnAimChanged);
+		BindAxe();
+	}
+	RefreshState();
+}
+
+void ULeviathanHudWidget::Unbind()
+{
+	if(ALeviathanCharacter* OldCharacter = Character.Get())
+	{
+		OldCharacter->OnAimChanged.Remove(AimChangedHandle);
+	}
+	if(ALeviathanAxe* OldAxe = BoundAxe.Get())
+	{
+		OldAxe->OnAxeEvent.Remove(AxeEventHandle);
+	}
+	AimChangedHandle.Reset();
+	AxeEventHandle.Reset();
+	Character.Reset();
+	BoundAxe.Reset();
+}
+
+void ULeviathanHudWidget::BindAxe()
+{
+	//The child actor can be respawned (blueprint recompile, class change), follow it on the next aim.
+	ALeviathanAxe* Axe = Character.IsValid()
+		? Cast<ALeviathanAxe>(Character->LeviathanAxeChildActorComponent->GetChildActor()) : nullptr;
+	if(Axe == BoundAxe.Get())
+	{
+		return;
+	}
+	if(ALeviathanAxe* OldAxe = BoundAxe.Get())
+	{
+		OldAxe->OnAxeEvent.Remove(AxeEventHandle);
+	}
+	BoundAxe = Axe;
+	AxeEventHandle = Axe ? Axe->OnAxeEvent.AddUObject(this, &ULeviathanHudWidget::OnAxeEvent) : FDelegateHandle();
+}
+
+void ULeviathanHudWidget::OnAimChanged(ALeviathanCharacter* InCharacter, bool bInAiming)
+{
+	BindAxe();
+	RefreshState();
+}
+
+void ULeviathanHudWidget::OnAxeEvent(ALeviathanAxe* Axe, ELeviathanAxeTraceEvent Event)
+{
+	RefreshState();
+}
+
+void ULeviathanHudWidget::RefreshState()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HudWidgetRefreshState);
+	const ALeviathanCharacter* Owner = Character.Get();
+	const bool bNewAiming = Owner && Owner->bAiming;
+	const bool bNewAxeThrown = Owner && Owner->bAxeThrown;
+	const bool bNewAxeRecalled = Owner && Owner->bAxeRecalled;
+	const bool bNewCanThrowAxe = Owner && Owner->CanThrowAxe();
+	const bool bNewCanRecallAxe = Owner && Owner->CanRecallAxe();
+	//The first refresh always goes through so the widget starts from the real state.
+	const bool bChanged = !bHasState || bNewAiming != bAiming || bNewAxeThrown != bAxeThrown || bNewAxeRecalled != bAxeRecalled
+		|| bNewCanThrowAxe != bCanThrowAxe || bNewCanRecallAxe != bCanRecallAxe;
+
+	bAiming = bNewAiming;
+	bAxeThrown = bNewAxeThrown;
+	bAxeRecalled = bNewAxeRecalled;
+	bCanThrowAxe = bNewCanThrowAxe;
+	bCanRecallAxe = bNewCanRecallAxe;
+	bHasState = true;
+
+	if(bCollapseWhenNotAiming)
+	{
+		//The recall prompt shows while the axe is out, whether aiming or not.
+		SetVisibility(bAiming || bCanRecallAxe ? ESlateVisibility::SelfHitTestInvisible : ESlateVisibility::Collapsed);
+	}
+	if(!bChanged)
+	{
+		return;
+	}
+	OnHudStateChanged();
+	//Setters on the children already invalidated the cache, the retainer still needs to be told to redraw.
+	if(HudRetainer)
+	{
+		HudRetainer->RequestRender();
+	}
+}
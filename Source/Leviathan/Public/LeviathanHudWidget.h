@@ -0,0 +1,69 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "LeviathanTrace.h"
+
+#include "LeviathanHudWidget.generated.h"
+
+/**Base for the aim HUD (Content/Character/Widget). Instead of property bindings that poll the character every frame it
+ * mirrors the aim and axe state from ALeviathanCharacter::OnAimChanged and ALeviathanAxe::OnAxeEvent and calls
+ * OnHudStateChanged only when something changed. Child widgets placed in HudCache (an InvalidationBox) and HudRetainer
+ * (a RetainerBox) are then only painted again on those events, so an unchanged HUD costs nothing.
+ * Widgets deriving from this must not use property bindings, a binding makes its widget volatile and undoes the cache.
+ */
+UCLASS(Abstract)
+class LEVIATHAN_API ULeviathanHudWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+	//Binds to another character, the owning player's pawn is used by default.
+	UFUNCTION(BlueprintCallable, Category = HUD)
+	void SetCharacter(class ALeviathanCharacter* InCharacter);
+
+	UPROPERTY(BlueprintReadOnly, Category = HUD)
+	bool bAiming = false;
+	UPROPERTY(BlueprintReadOnly, Category = HUD)
+	bool bAxeThrown = false;
+	UPROPERTY(BlueprintReadOnly, Category = HUD)
+	bool bAxeRecalled = false;
+	//ALeviathanCharacter::CanThrowAxe and CanRecallAxe at the last change.
+	UPROPERTY(BlueprintReadOnly, Category = HUD)
+	bool bCanThrowAxe = false;
+	UPROPERTY(BlueprintReadOnly, Category = HUD)
+	bool bCanRecallAxe = false;
+
+	//Collapses the whole HUD while it shows nothing, not aiming and no axe to recall. Collapsed widgets are neither
+	//prepassed nor painted.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = HUD)
+	bool bCollapseWhenNotAiming = false;
+
+protected:
+	virtual void NativeConstruct() override;
+	virtual void NativeDestruct() override;
+
+	//Called once per state change, update the child widgets from the mirrored state here.
+	UFUNCTION(BlueprintImplementableEvent, Category = HUD)
+	void OnHudStateChanged();
+
+	UPROPERTY(BlueprintReadOnly, Category = HUD, meta = (BindWidgetOptional))
+	class UInvalidationBox* HudCache;
+	UPROPERTY(BlueprintReadOnly, Category = HUD, meta = (BindWidgetOptional))
+	class URetainerBox* HudRetainer;
+
+private:
+	void Unbind();
+	void BindAxe();
+	void OnAimChanged(class ALeviathanCharacter* InCharacter, bool bInAiming);
+	void OnAxeEvent(class ALeviathanAxe* Axe, ELeviathanAxeTraceEvent Event);
+	void RefreshState();
+
+	TWeakObjectPtr<class ALeviathanCharacter> Character;
+	TWeakObjectPtr<class ALeviathanAxe> BoundAxe;
+	FDelegateHandle AimChangedHandle;
+	FDelegateHandle AxeEventHandle;
+	bool bHasState = false;
+};
@@ -0,0 +1,224 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanImpactMarks.h"
+
+#include "Leviathan.h"
+#include "LeviathanAxe.h"
+#include "LeviathanMemory.h"
+#include "Components/DecalComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "EngineUtils.h"
+#include "TimerManager.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+DECLARE_CYCLE_STAT(TEXT("ImpactMarks AddMark"), STAT_ImpactMarksAddMark, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("ImpactMarks AddLodgedWeapon"), STAT_ImpactMarksAddLodgedWeapon, STATGROUP_Leviathan);
+
+//Instances that are not in use are scaled to nothing rather than removed, so indexes and buffers never change.
+static const FTransform HiddenInstanceTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+
+ALeviathanImpactMarks::ALeviathanImpactMarks()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	LodgedWeapons = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("LodgedWeapons"));
+	RootComponent = LodgedWeapons;
+	LodgedWeapons->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	LodgedWeapons->SetCanEverAffectNavigation(false);
+}
+
+void ALeviathanImpactMarks::BeginPlay()
+{
+	LEVIATHAN_LLM_SCOPE(AxeFX);
+	Super::BeginPlay();
+
+	Decals.Reserve(MaxMarks);
+	for(int32 Index = 0; Index < MaxMarks; Index++)
+	{
+		UDecalComponent* Decal = NewObject<UDecalComponent>(this);
+		Decal->SetupAttachment(RootComponent);
+		Decal->SetAbsolute(true, true, true);
+		Decal->SetVisibility(false);
+		Decal->RegisterComponent();
+		Decals.Add(Decal);
+	}
+	DecalExpireTimes.Init(0.f, MaxMarks);
+	DecalInstances.SetNum(MaxMarks);
+}
+
+ALeviathanImpactMarks* ALeviathanImpactMarks::Get(const UWorld* World)
+{
+	static TWeakObjectPtr<ALeviathanImpactMarks> Cached;
+	if(Cached.IsValid() && Cached->GetWorld() == World)
+	{
+		return Cached.Get();
+	}
+	Cached = nullptr;
+	if(World)
+	{
+		for(TActorIterator<ALeviathanImpactMarks> It(const_cast<UWorld*>(World)); It; ++It)
+		{
+			Cached = *It;
+			break;
+		}
+	}
+	return Cached.Get();
+}
+
+void ALeviathanImpactMarks::AddMarkFromAxe(ALeviathanAxe& Axe)
+{
+	if(ALeviathanImpactMarks* Marks = Get(Axe.GetWorld()))
+	{
+		//BaseLodgedRotator holds the pitch offset the blade really went in with, calling
+		//CalculateImpactPitchOffset again would roll a new random one.
+		Marks->AddMark(Axe.ImpactLocation, Axe.ImpactNormal, Axe.ThrowDirection, Axe.BaseLodgedRotator.Pitch,
+			Axe.ESurfaceHit);
+	}
+}
+
+void ALeviathanImpactMarks::AddMark(FVector Location, FVector Normal, FVector BladeDirection, float PitchOffset,
+	TEnumAsByte<EPhysicalSurface> Surface)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ImpactMarksAddMark);
+	const FLeviathanImpactMarkStyle* Style = SurfaceStyles.Find(Surface);
+	if(!Style)
+	{
+		Style = &DefaultStyle;
+	}
+	if(!Style->Material || Decals.Num() == 0)
+	{
+		return;
+	}
+
+	//Project into the surface, with the long side of the mark along the blade path on the surface.
+	const FVector Forward = -Normal.GetSafeNormal();
+	FVector Up = FVector::VectorPlaneProject(BladeDirection, Forward).GetSafeNormal();
+	if(Up.IsNearlyZero())
+	{
+		Up = FVector::VectorPlaneProject(FVector::UpVector, Forward).GetSafeNormal();
+	}
+	FQuat Rotation = FRotationMatrix::MakeFromXZ(Forward, Up).ToQuat();
+	//Slant the mark the same way the blade is slanted in the surface.
+	Rotation = Rotation * FQuat(FVector::ForwardVector, FMath::DegreesToRadians(PitchOffset));
+
+	const int32 DecalIndex = NextDecal;
+	UDecalComponent* Decal = Decals[DecalIndex];
+	NextDecal = (NextDecal + 1) % Decals.Num();
+	Decal->DecalSize = Style->Size;
+	Decal->SetWorldLocationAndRotation(Location, Rotation);
+	Decal->SetVisibility(true);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float ExpireTime = Style->Lifetime > 0.f ? Now + Style->Lifetime : 0.f;
+	DecalExpireTimes[DecalIndex] = ExpireTime;
+	UMaterialInterface* Material = Style->Material;
+	if(ExpireTime > 0.f && Style->ExpireTimeParameter != NAME_None)
+	{
+		UMaterialInstanceDynamic* Instance = GetDecalInstance(DecalIndex, Style->Material);
+		Instance->SetScalarParameterValue(Style->ExpireTimeParameter, ExpireTime);
+		Material = Instance;
+	}
+	//Only dirties the render state when the decal changes style.
+	if(Decal->GetDecalMaterial() != Material)
+	{
+		Decal->SetDecalMaterial(Material);
+	}
+	ScheduleExpiry();
+}
+
+UMaterialInstanceDynamic* ALeviathanImpactMarks::GetDecalInstance(int32 DecalIndex, UMaterialInterface* Material)
+{
+	TArray<UMaterialInstanceDynamic*>& Instances = DecalInstances[DecalIndex].Instances;
+	for(UMaterialInstanceDynamic* Instance : Instances)
+	{
+		if(Instance->Parent == Material)
+		{
+			return Instance;
+		}
+	}
+	LEVIATHAN_LLM_SCOPE(AxeFX);
+	UMaterialInstanceDynamic* Instance = UMaterialInstanceDynamic::Create(Material, this);
+	Instances.Add(Instance);
+	return Instance;
+}
+
+void ALeviathanImpactMarks::ScheduleExpiry()
+{
+	float NextExpireTime = 0.f;
+	for(const float ExpireTime : DecalExpireTimes)
+	{
+		if(ExpireTime > 0.f && (NextExpireTime == 0.f || ExpireTime < NextExpireTime))
+		{
+			NextExpireTime = ExpireTime;
+		}
+	}
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	if(NextExpireTime == 0.f)
+	{
+		TimerManager.ClearTimer(ExpireTimer);
+		return;
+	}
+	const float Delay = FMath::Max(NextExpireTime - GetWorld()->GetTimeSeconds(), KINDA_SMALL_NUMBER);
+	TimerManager.SetTimer(ExpireTimer, this, &ALeviathanImpactMarks::ExpireMarks, Delay, false);
+}
+
+void ALeviathanImpactMarks::ExpireMarks()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	for(int32 Index = 0; Index < Decals.Num(); Index++)
+	{
+		if(DecalExpireTimes[Index] > 0.f && DecalExpireTimes[Index] <= Now)
+		{
+			Decals[Index]->SetVisibility(false);
+			DecalExpireTimes[Index] = 0.f;
+		}
+	}
+	ScheduleExpiry();
+}
+
+int32 ALeviathanImpactMarks::AddLodgedWeapon(const FTransform& WorldTransform)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ImpactMarksAddLodgedWeapon);
+	LEVIATHAN_LLM_SCOPE(Axe);
+	int32 Index = NextLodgedWeapon;
+	NextLodgedWeapon = (NextLodgedWeapon + 1) % MaxLodgedWeapons;
+	if(Index < LodgedWeapons->GetInstanceCount())
+	{
+		LodgedWeapons->UpdateInstanceTransform(Index, WorldTransform, true, true, true);
+	}
+	else
+	{
+		Index = LodgedWeapons->AddInstanceWorldSpace(WorldTransform);
+	}
+	return Index;
+}
+
+void ALeviathanImpactMarks::ConvertToLodgedWeapon(AActor* Weapon)
+{
+	if(!Weapon)
+	{
+		return;
+	}
+	AddLodgedWeapon(Weapon->GetActorTransform());
+	Weapon->Destroy();
+}
+
+void ALeviathanImpactMarks::ClearAll()
+{
+	for(UDecalComponent* Decal : Decals)
+	{
+		Decal->SetVisibility(false);
+	}
+	for(float& ExpireTime : DecalExpireTimes)
+	{
+		ExpireTime = 0.f;
+	}
+	GetWorldTimerManager().ClearTimer(ExpireTimer);
+	const int32 NumInstances = LodgedWeapons->GetInstanceCount();
+	for(int32 Index = 0; Index < NumInstances; Index++)
+	{
+		LodgedWeapons->UpdateInstanceTransform(Index, HiddenInstanceTransform, true, Index == NumInstances - 1, true);
+	}
+	NextDecal = 0;
+	NextLodgedWeapon = 0;
+}
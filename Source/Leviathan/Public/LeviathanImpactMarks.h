@@ -0,0 +1,114 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "GameFramework/Actor.h"
+
+#include "LeviathanImpactMarks.generated.h"
+
+//How a lodge looks on one surface type.
+USTRUCT(BlueprintType)
+struct FLeviathanImpactMarkStyle
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ImpactMarks)
+	class UMaterialInterface* Material = nullptr;
+	//Decal extent, X is the depth along the impact normal.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ImpactMarks)
+	FVector Size = FVector(8.f, 6.f, 24.f);
+	//Seconds before the mark is hidden, 0 keeps it until its decal is reused.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ImpactMarks)
+	float Lifetime = 0.f;
+	/**Scalar parameter of Material set to the world time the mark expires at, so the material can fade it out with
+	 * the Time node. None leaves the material alone.*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ImpactMarks)
+	FName ExpireTimeParameter = NAME_None;
+};
+
+//Fade instances of one pooled decal, one per style material the decal has shown.
+USTRUCT()
+struct FLeviathanImpactMarkInstances
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<class UMaterialInstanceDynamic*> Instances;
+};
+
+/**Leaves marks where the axe lodged and keeps leftover lodged weapons around, with a fixed cost.
+ * Marks are a ring of MaxMarks decal components created up front, the newest mark takes the oldest decal. Lodged
+ * weapons are instances of LodgedWeapons, up to MaxLodgedWeapons, the newest replacing the oldest.
+ * Place one in the level, LodgeAxe finds it on its own.
+ */
+UCLASS()
+class LEVIATHAN_API ALeviathanImpactMarks : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ALeviathanImpactMarks();
+
+	//Leftover weapons. Set a static mesh with the same pivot as the weapon actors that are converted.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = ImpactMarks)
+	class UInstancedStaticMeshComponent* LodgedWeapons;
+
+	//Style per surface, surfaces not in the map use DefaultStyle.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ImpactMarks)
+	TMap<TEnumAsByte<EPhysicalSurface>, FLeviathanImpactMarkStyle> SurfaceStyles;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ImpactMarks)
+	FLeviathanImpactMarkStyle DefaultStyle;
+
+	UPROPERTY(EditAnywhere, Category = ImpactMarks, meta = (ClampMin = "1"))
+	int32 MaxMarks = 64;
+	UPROPERTY(EditAnywhere, Category = ImpactMarks, meta = (ClampMin = "1"))
+	int32 MaxLodgedWeapons = 16;
+
+	/**Puts a mark on the surface.
+	 * @param BladeDirection Direction the weapon travelled, the mark is stretched along it on the surface
+	 * @param PitchOffset Slant of the blade in degrees, as from ALeviathanAxe::CalculateImpactPitchOffset*/
+	UFUNCTION(BlueprintCallable, Category = ImpactMarks)
+	void AddMark(FVector Location, FVector Normal, FVector BladeDirection, float PitchOffset,
+		TEnumAsByte<EPhysicalSurface> Surface);
+
+	//Adds a lodged weapon instance, returns its instance index.
+	UFUNCTION(BlueprintCallable, Category = ImpactMarks)
+	int32 AddLodgedWeapon(const FTransform& WorldTransform);
+
+	//Replaces a weapon actor stuck in the world with an instance and destroys the actor.
+	UFUNCTION(BlueprintCallable, Category = ImpactMarks)
+	void ConvertToLodgedWeapon(AActor* Weapon);
+
+	//Hides every mark and lodged weapon.
+	UFUNCTION(BlueprintCallable, Category = ImpactMarks)
+	void ClearAll();
+
+	//Marks where the axe just lodged, does nothing if the level has no ALeviathanImpactMarks.
+	static void AddMarkFromAxe(class ALeviathanAxe& Axe);
+
+	static ALeviathanImpactMarks* Get(const UWorld* World);
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	//Hides the marks whose lifetime is over and waits for the next one to expire.
+	void ExpireMarks();
+	void ScheduleExpiry();
+	//Fade instance of Material for the decal, created the first time the decal shows Material.
+	class UMaterialInstanceDynamic* GetDecalInstance(int32 DecalIndex, class UMaterialInterface* Material);
+
+	//Pooled decals never use the engine lifespan (SetFadeOut), it destroys the component when it runs out.
+	UPROPERTY(Transient)
+	TArray<class UDecalComponent*> Decals;
+	//World time each decal is hidden at, 0 for marks without a lifetime.
+	TArray<float> DecalExpireTimes;
+	//Per decal, so two marks of the same style fading at different times don't share one parameter.
+	UPROPERTY(Transient)
+	TArray<FLeviathanImpactMarkInstances> DecalInstances;
+	FTimerHandle ExpireTimer;
+	int32 NextDecal = 0;
+	int32 NextLodgedWeapon = 0;
+};
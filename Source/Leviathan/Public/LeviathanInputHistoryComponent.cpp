@@ -0,0 +1,212 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanInputHistoryComponent.h"
+
+#include "Leviathan.h"
+#include "LeviathanCharacter.h"
+#include "Camera/CameraComponent.h"
+#include "Framework/Application/IInputProcessor.h"
+#include "Framework/Application/SlateApplication.h"
+#include "GameFramework/InputSettings.h"
+
+DECLARE_CYCLE_STAT(TEXT("InputHistory Tick"), STAT_InputHistoryTick, STATGROUP_Leviathan);
+
+//Sees key and mouse presses before the player controller does and stamps the ones bound to aim or throw.
+class FLeviathanInputProcessor : public IInputProcessor
+{
+public:
+	explicit FLeviathanInputProcessor(ULeviathanInputHistoryComponent* InOwner)
+		: Owner(InOwner)
+	{
+		const UInputSettings* Settings = UInputSettings::GetInputSettings();
+		TArray<FInputActionKeyMapping> ActionMappings;
+		Settings->GetActionMappingByName(TEXT("ThrowAxe"), ActionMappings);
+		for(const FInputActionKeyMapping& Mapping : ActionMappings)
+		{
+			ThrowKeys.Add(Mapping.Key);
+		}
+		//Aim is bound as an axis in DefaultInput.ini.
+		TArray<FInputAxisKeyMapping> AxisMappings;
+		Settings->GetAxisMappingByName(TEXT("Aim"), AxisMappings);
+		for(const FInputAxisKeyMapping& Mapping : AxisMappings)
+		{
+			AimKeys.Add(Mapping.Key);
+		}
+	}
+
+	void Detach() { Owner = nullptr; }
+
+	virtual void Tick(const float DeltaTime, FSlateApplication& SlateApp, TSharedRef<ICursor> Cursor) override
+	{
+	}
+
+	virtual bool HandleKeyDownEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override
+	{
+		if(!InKeyEvent.IsRepeat())
+		{
+			OnKeyPressed(InKeyEvent.GetKey());
+		}
+		return false;
+	}
+
+	virtual bool HandleMouseButtonDownEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override
+	{
+		OnKeyPressed(MouseEvent.GetEffectingButton());
+		return false;
+	}
+
+private:
+	void OnKeyPressed(const FKey& Key)
+	{
+		if(!Owner)
+		{
+			return;
+		}
+		const double Now = FPlatformTime::Seconds();
+		if(ThrowKeys.Contains(Key))
+		{
+			Owner->OnInputPressed(ELeviathanTimedInput::ThrowAxe, Now);
+		}
+		if(AimKeys.Contains(Key))
+		{
+			Owner->OnInputPressed(ELeviathanTimedInput::Aim, Now);
+		}
+	}
+
+	ULeviathanInputHistoryComponent* Owner;
+	TSet<FKey> ThrowKeys;
+	TSet<FKey> AimKeys;
+};
+
+ULeviathanInputHistoryComponent::ULeviathanInputHistoryComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	//Record after the camera boom has moved the camera for this frame.
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+}
+
+void ULeviathanInputHistoryComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	const APawn* Pawn = Cast<APawn>(GetOwner());
+	if(Pawn && Pawn->IsLocallyControlled() && FSlateApplication::IsInitialized())
+	{
+		InputProcessor = MakeShared<FLeviathanInputProcessor>(this);
+		FSlateApplication::Get().RegisterInputPreProcessor(InputProcessor);
+	}
+}
+
+void ULeviathanInputHistoryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if(InputProcessor.IsValid())
+	{
+		InputProcessor->Detach();
+		if(FSlateApplication::IsInitialized())
+		{
+			FSlateApplication::Get().UnregisterInputPreProcessor(InputProcessor);
+		}
+		InputProcessor.Reset();
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void ULeviathanInputHistoryComponent::SetRecording(bool bRecord)
+{
+	SetComponentTickEnabled(bRecord);
+	if(bRecord)
+	{
+		//Old poses are from before the aim started, and a press while aiming needs the current pose right away.
+		PoseCount = 0;
+		PoseHead = 0;
+		RecordPose();
+	}
+}
+
+void ULeviathanInputHistoryComponent::OnInputPressed(ELeviathanTimedInput Input, double Time)
+{
+	PressedTimes[uint8(Input)] = Time;
+	if(Input == ELeviathanTimedInput::ThrowAxe)
+	{
+		bThrowPoseConsumed = false;
+	}
+}
+
+float ULeviathanInputHistoryComponent::GetSecondsSincePressed(ELeviathanTimedInput Input) const
+{
+	const double Pressed = PressedTimes[uint8(Input)];
+	return Pressed > 0.0 ? float(FPlatformTime::Seconds() - Pressed) : -1.f;
+}
+
+void ULeviathanInputHistoryComponent::TickComponent(float DeltaTime, ELevelTick TickType,
+	FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_InputHistoryTick);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	RecordPose();
+}
+
+void ULeviathanInputHistoryComponent::RecordPose()
+{
+	const ALeviathanCharacter* Character = Cast<ALeviathanCharacter>(GetOwner());
+	if(!Character)
+	{
+		return;
+	}
+	const int32 Index = (PoseHead + PoseCount) % MaxPoses;
+	FLeviathanCameraPose& Pose = Poses[Index];
+	Pose.Time = FPlatformTime::Seconds();
+	Pose.Location = Character->FollowCamera->GetComponentLocation();
+	Pose.Rotation = Character->FollowCamera->GetComponentQuat();
+	if(PoseCount < MaxPoses)
+	{
+		PoseCount++;
+	}
+	else
+	{
+		PoseHead = (PoseHead + 1) % MaxPoses;
+	}
+
+	//Drop poses older than the history, but always keep the newest.
+	while(PoseCount > 1 && Pose.Time - Poses[PoseHead].Time > HistorySeconds)
+	{
+		PoseHead = (PoseHead + 1) % MaxPoses;
+		PoseCount--;
+	}
+}
+
+bool ULeviathanInputHistoryComponent::GetPoseAtTime(double Time, FLeviathanCameraPose& OutPose) const
+{
+	//Presses are stamped when Slate sees them, before the world ticks, and poses at the end of the world tick. So the
+	//newest pose not newer than the press is the frame on screen when the button went down. Walk back from the newest,
+	//the graph usually asks within a couple of frames.
+	for(int32 Offset = PoseCount - 1; Offset >= 0; Offset--)
+	{
+		const FLeviathanCameraPose& Pose = Poses[(PoseHead + Offset) % MaxPoses];
+		if(Pose.Time <= Time)
+		{
+			OutPose = Pose;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ULeviathanInputHistoryComponent::ConsumeThrowPose(FVector& OutLocation, FRotator& OutRotation)
+{
+	if(bThrowPoseConsumed)
+	{
+		return false;
+	}
+	bThrowPoseConsumed = true;
+
+	FLeviathanCameraPose Pose;
+	if(!GetPoseAtTime(PressedTimes[uint8(ELeviathanTimedInput::ThrowAxe)], Pose))
+	{
+		return false;
+	}
+	OutLocation = Pose.Location;
+	OutRotation = Pose.Rotation.Rotator();
+	return true;
+}
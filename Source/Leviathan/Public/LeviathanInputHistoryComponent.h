@@ -0,0 +1,74 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+
+#include "LeviathanInputHistoryComponent.generated.h"
+
+//Actions whose press time is captured.
+UENUM(BlueprintType)
+enum class ELeviathanTimedInput : uint8 { Aim, ThrowAxe };
+
+//Camera pose at the end of a frame.
+struct FLeviathanCameraPose
+{
+	double Time = 0.0;
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+};
+
+/**Timestamps the aim and throw presses as soon as Slate receives them (before the Blueprint graph gets to Throw) and
+ * keeps a short history of the follow camera poses. ALeviathanAxe::Throw then uses the last pose presented before the
+ * button was pressed, so the throw goes where the player was looking even if the graph gets to it frames later.
+ */
+UCLASS(ClassGroup = (Axe), meta = (BlueprintSpawnableComponent))
+class LEVIATHAN_API ULeviathanInputHistoryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	ULeviathanInputHistoryComponent();
+
+	//Camera poses are only recorded while aiming, turned on and off by ALeviathanCharacter::Aim.
+	void SetRecording(bool bRecord);
+
+	//Seconds since the action was last pressed, -1 if it never was.
+	UFUNCTION(BlueprintPure, Category = AxeAim)
+	float GetSecondsSincePressed(ELeviathanTimedInput Input) const;
+
+	/**Returns the camera pose at the time the throw was pressed, once per press.
+	 * @return false if there is no unused press inside the history, use the live camera then*/
+	bool ConsumeThrowPose(FVector& OutLocation, FRotator& OutRotation);
+
+	//Newest pose recorded at or before Time. False if Time is older than the history.
+	bool GetPoseAtTime(double Time, FLeviathanCameraPose& OutPose) const;
+
+	void OnInputPressed(ELeviathanTimedInput Input, double Time);
+
+	//Seconds of camera poses kept. A press older than this falls back to the live camera.
+	UPROPERTY(EditAnywhere, Category = AxeAim, meta = (ClampMin = "0.05"))
+	float HistorySeconds = 0.5f;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
+		FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	void RecordPose();
+
+	//Ring of poses, oldest at PoseHead once full.
+	static constexpr int32 MaxPoses = 64;
+	FLeviathanCameraPose Poses[MaxPoses];
+	int32 PoseHead = 0;
+	int32 PoseCount = 0;
+
+	double PressedTimes[2] = { 0.0, 0.0 };
+	bool bThrowPoseConsumed = true;
+
+	TSharedPtr<class FLeviathanInputProcessor> InputProcessor;
+};
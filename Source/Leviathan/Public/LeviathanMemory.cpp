@@ -0,0 +1,129 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanMemory.h"
+
+#include "Leviathan.h"
+#include "LeviathanPerfBudget.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+#if STATS
+#define LEVIATHAN_LLM_STATFNAME(Stat) GET_STATFNAME(Stat)
+#else
+#define LEVIATHAN_LLM_STATFNAME(Stat) NAME_None
+#endif
+
+DECLARE_LLM_MEMORY_STAT(TEXT("LeviathanAxe"), STAT_LeviathanAxeLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("LeviathanCharacter"), STAT_LeviathanCharacterLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("LeviathanAxeFX"), STAT_LeviathanAxeFXLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("LeviathanAxeAudio"), STAT_LeviathanAxeAudioLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("LeviathanAxeTraces"), STAT_LeviathanAxeTracesLLM, STATGROUP_LLMFULL);
+
+//Peak bytes of every tag, sampled at the end of the frame.
+static int64 HighWaterMarks[int32(ELeviathanMemoryTag::Count)];
+static FDelegateHandle EndFrameHandle;
+#endif
+
+void FLeviathanMemory::Startup()
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	FLowLevelMemTracker& Tracker = FLowLevelMemTracker::Get();
+	if(!Tracker.IsEnabled())
+	{
+		return;
+	}
+	const FName StatNames[] =
+	{
+		LEVIATHAN_LLM_STATFNAME(STAT_LeviathanAxeLLM),
+		LEVIATHAN_LLM_STATFNAME(STAT_LeviathanCharacterLLM),
+		LEVIATHAN_LLM_STATFNAME(STAT_LeviathanAxeFXLLM),
+		LEVIATHAN_LLM_STATFNAME(STAT_LeviathanAxeAudioLLM),
+		LEVIATHAN_LLM_STATFNAME(STAT_LeviathanAxeTracesLLM),
+	};
+	static_assert(UE_ARRAY_COUNT(StatNames) == int32(ELeviathanMemoryTag::Count), "Missing LLM stat for a tag");
+
+	for(int32 Index = 0; Index < int32(ELeviathanMemoryTag::Count); Index++)
+	{
+		const ELeviathanMemoryTag Tag = ELeviathanMemoryTag(Index);
+		Tracker.RegisterProjectTag(int32(ToLLMTag(Tag)), GetTagName(Tag), StatNames[Index], NAME_None);
+	}
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&FLeviathanMemory::SampleHighWaterMarks);
+#endif
+}
+
+void FLeviathanMemory::Shutdown()
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+#endif
+}
+
+const TCHAR* FLeviathanMemory::GetTagName(ELeviathanMemoryTag Tag)
+{
+	switch(Tag)
+	{
+		case ELeviathanMemoryTag::Axe: return TEXT("LeviathanAxe");
+		case ELeviathanMemoryTag::Character: return TEXT("LeviathanCharacter");
+		case ELeviathanMemoryTag::AxeFX: return TEXT("LeviathanAxeFX");
+		case ELeviathanMemoryTag::AxeAudio: return TEXT("LeviathanAxeAudio");
+		case ELeviathanMemoryTag::AxeTraces: return TEXT("LeviathanAxeTraces");
+		default: return TEXT("Unknown");
+	}
+}
+
+void FLeviathanMemory::SampleHighWaterMarks()
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	FLowLevelMemTracker& Tracker = FLowLevelMemTracker::Get();
+	for(int32 Index = 0; Index < int32(ELeviathanMemoryTag::Count); Index++)
+	{
+		const int64 Amount = Tracker.GetTagAmountForTracker(ELLMTracker::Default, ToLLMTag(ELeviathanMemoryTag(Index)));
+		HighWaterMarks[Index] = FMath::Max(HighWaterMarks[Index], Amount);
+	}
+#endif
+}
+
+bool FLeviathanMemory::DumpReport()
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	FLowLevelMemTracker& Tracker = FLowLevelMemTracker::Get();
+	if(!Tracker.IsEnabled())
+	{
+		UE_LOG(LogLeviathan, Warning, TEXT("LLM is off, run with -llm to get the Leviathan memory report"));
+		return true;
+	}
+	SampleHighWaterMarks();
+
+	const ULeviathanPerfSettings* Settings = GetDefault<ULeviathanPerfSettings>();
+	const double BytesToMB = 1.0 / (1024.0 * 1024.0);
+	bool bPassed = true;
+
+	UE_LOG(LogLeviathan, Display, TEXT("%-20s %12s %12s %12s"), TEXT("Tag"), TEXT("Current MB"), TEXT("Peak MB"),
+		TEXT("Budget MB"));
+	for(int32 Index = 0; Index < int32(ELeviathanMemoryTag::Count); Index++)
+	{
+		const ELeviathanMemoryTag Tag = ELeviathanMemoryTag(Index);
+		const double CurrentMB = Tracker.GetTagAmountForTracker(ELLMTracker::Default, ToLLMTag(Tag)) * BytesToMB;
+		const double PeakMB = HighWaterMarks[Index] * BytesToMB;
+		const float* BudgetMB = Settings->MemoryBudgetsMB.Find(FName(GetTagName(Tag)));
+		const bool bOverBudget = BudgetMB && PeakMB > *BudgetMB;
+		bPassed &= !bOverBudget;
+
+		UE_LOG(LogLeviathan, Display, TEXT("%-20s %12.3f %12.3f %12.3f%s"), GetTagName(Tag), CurrentMB, PeakMB,
+			BudgetMB ? *BudgetMB : 0.f, bOverBudget ? TEXT("  OVER BUDGET") : TEXT(""));
+	}
+	return bPassed;
+#else
+	UE_LOG(LogLeviathan, Warning, TEXT("LLM is compiled out in this build"));
+	return true;
+#endif
+}
+
+static FAutoConsoleCommand MemoryReportCommand(
+	TEXT("Leviathan.Memory.Report"),
+	TEXT("Dumps current and peak memory of the Leviathan LLM tags against their budgets (needs -llm)."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FLeviathanMemory::DumpReport();
+	}));
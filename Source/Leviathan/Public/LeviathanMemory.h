@@ -0,0 +1,49 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+//Subsystems we want to see in LLM (run with -llm, then "stat LLMFULL" or Leviathan.Memory.Report).
+enum class ELeviathanMemoryTag : uint8
+{
+	Axe,
+	Character,
+	AxeFX,
+	AxeAudio,
+	AxeTraces,
+	Count
+};
+
+/**Registers the Leviathan LLM tags and keeps the high-water mark of every tag so they can be checked against the
+ * memory budgets in ULeviathanPerfSettings.
+ * Console command: Leviathan.Memory.Report
+ */
+class LEVIATHAN_API FLeviathanMemory
+{
+public:
+	static void Startup();
+	static void Shutdown();
+
+	static const TCHAR* GetTagName(ELeviathanMemoryTag Tag);
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	static ELLMTag ToLLMTag(ELeviathanMemoryTag Tag)
+	{
+		return ELLMTag(int32(ELLMTag::ProjectTagStart) + int32(Tag));
+	}
+#endif
+
+	//Writes current, peak and budget of every tag to the log. Returns false if any tag is over its budget.
+	static bool DumpReport();
+
+private:
+	static void SampleHighWaterMarks();
+};
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+#define LEVIATHAN_LLM_SCOPE(Tag) LLM_SCOPE(FLeviathanMemory::ToLLMTag(ELeviathanMemoryTag::Tag))
+#else
+#define LEVIATHAN_LLM_SCOPE(Tag)
+#endif
@@ -0,0 +1,561 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanNavigation.h"
+
+#include "Leviathan.h"
+#include "AIController.h"
+#include "Containers/Ticker.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/Parse.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Navigation Request"), STAT_NavigationRequest, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Navigation Tick"), STAT_NavigationTick, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("Navigation PathFound"), STAT_NavigationPathFound, STATGROUP_Leviathan);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Navigation Queries Issued"), STAT_NavigationQueriesIssued, STATGROUP_Leviathan);
+
+static TAutoConsoleVariable<int32> CVarNavQueriesPerFrame(
+	TEXT("Leviathan.Nav.QueriesPerFrame"),
+	16,
+	TEXT("Path queries handed to the navigation system per frame, the rest wait for the next frames."));
+static TAutoConsoleVariable<float> CVarNavRegionSize(
+	TEXT("Leviathan.Nav.RegionSize"),
+	250.f,
+	TEXT("Size of the start and goal regions, agents whose start and goal fall in the same regions share a path."));
+static TAutoConsoleVariable<float> CVarNavCacheSeconds(
+	TEXT("Leviathan.Nav.CacheSeconds"),
+	1.f,
+	TEXT("How long a found path is handed out again to agents asking for the same regions."));
+static TAutoConsoleVariable<float> CVarNavRepairDistance(
+	TEXT("Leviathan.Nav.RepairDistance"),
+	600.f,
+	TEXT("Goal moves shorter than this splice the current path instead of replanning."));
+static TAutoConsoleVariable<int32> CVarNavShare(
+	TEXT("Leviathan.Nav.Share"),
+	1,
+	TEXT("0 turns off path sharing, caching and repair, every request is its own query. For comparison."));
+
+//Points from the end of the path checked for a direct line to the moved goal.
+static constexpr int32 MaxRepairPoints = 4;
+
+//Adds the game thread time of the scope to the stats, only on the public entry points.
+struct FNavCycleScope
+{
+	explicit FNavCycleScope(uint64& InTotal) : Total(InTotal), Start(FPlatformTime::Cycles64()) {}
+	~FNavCycleScope() { Total += FPlatformTime::Cycles64() - Start; }
+
+	uint64& Total;
+	uint64 Start;
+};
+
+bool ULeviathanNavigationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void ULeviathanNavigationSubsystem::Deinitialize()
+{
+	Pending.Reset();
+	QueryOrder.Reset();
+	InFlight.Reset();
+	Cache.Reset();
+	Agents.Reset();
+	Super::Deinitialize();
+}
+
+ETickableTickType ULeviathanNavigationSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId ULeviathanNavigationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULeviathanNavigationSubsystem, STATGROUP_Tickables);
+}
+
+ANavigationData* ULeviathanNavigationSubsystem::GetNavData() const
+{
+	//AI_Master is the only agent type, everything goes on the default navmesh.
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	return NavSys ? NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+}
+
+ULeviathanNavigationSubsystem::FPathKey ULeviathanNavigationSubsystem::MakeKey(const FVector& Start,
+	const FVector& Goal)
+{
+	if(CVarNavShare.GetValueOnGameThread() == 0)
+	{
+		return FPathKey(FIntVector::ZeroValue, FIntVector::ZeroValue, NextUniqueKey++);
+	}
+	const float RegionSize = FMath::Max(CVarNavRegionSize.GetValueOnGameThread(), 1.f);
+	auto ToRegion = [RegionSize](const FVector& Location)
+	{
+		return FIntVector(FMath::FloorToInt(Location.X / RegionSize), FMath::FloorToInt(Location.Y / RegionSize),
+			FMath::FloorToInt(Location.Z / RegionSize));
+	};
+	return FPathKey(ToRegion(Start), ToRegion(Goal), 0);
+}
+
+void ULeviathanNavigationSubsystem::RequestPath(const FVector& Start, const FVector& Goal, FLeviathanPathReady OnReady)
+{
+	FNavCycleScope CycleScope(Stats.GameThreadCycles);
+	QueuePath(Start, Goal, MoveTemp(OnReady));
+}
+
+void ULeviathanNavigationSubsystem::QueuePath(const FVector& Start, const FVector& Goal, FLeviathanPathReady OnReady)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NavigationRequest);
+	Stats.Requests++;
+
+	const FPathKey Key = MakeKey(Start, Goal);
+	if(const FCachedPath* Cached = Cache.Find(Key))
+	{
+		Stats.CacheHits++;
+		OnReady.ExecuteIfBound(Cached->Points);
+		return;
+	}
+	if(FPendingQuery* Query = Pending.Find(Key))
+	{
+		Stats.SharedQueries++;
+		Query->Waiters.Add(MoveTemp(OnReady));
+		return;
+	}
+	FPendingQuery& Query = Pending.Add(Key);
+	Query.Start = Start;
+	Query.Goal = Goal;
+	Query.Waiters.Add(MoveTemp(OnReady));
+	QueryOrder.Add(Key);
+}
+
+bool ULeviathanNavigationSubsystem::RepairPath(TArray<FVector>& Points, int32 FirstPoint, const FVector& NewGoal)
+{
+	FNavCycleScope CycleScope(Stats.GameThreadCycles);
+	return TryRepair(Points, FirstPoint, NewGoal);
+}
+
+bool ULeviathanNavigationSubsystem::TryRepair(TArray<FVector>& Points, int32 FirstPoint, const FVector& NewGoal)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NavigationRequest);
+	if(CVarNavShare.GetValueOnGameThread() == 0 || Points.Num() < 2 || !Points.IsValidIndex(FirstPoint))
+	{
+		return false;
+	}
+	const FVector& OldGoal = Points.Last();
+	if(FVector::DistSquared(OldGoal, NewGoal) > FMath::Square(CVarNavRepairDistance.GetValueOnGameThread()))
+	{
+		return false;
+	}
+
+	//Walk back from the old goal, the first point with a clear line on the navmesh to the new goal is kept.
+	const int32 LastPoint = Points.Num() - 1;
+	const int32 StopPoint = FMath::Max(FirstPoint, LastPoint - MaxRepairPoints);
+	for(int32 Index = LastPoint; Index >= StopPoint; Index--)
+	{
+		FVector HitLocation;
+		if(!UNavigationSystemV1::NavigationRaycast(GetWorld(), Points[Index], NewGoal, HitLocation))
+		{
+			Points.SetNum(Index + 1, false);
+			Points.Add(NewGoal);
+			Points.RemoveAt(0, FirstPoint, false);
+			Stats.Repairs++;
+			return Points.Num() >= 2;
+		}
+	}
+	return false;
+}
+
+void ULeviathanNavigationSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NavigationTick);
+	FNavCycleScope CycleScope(Stats.GameThreadCycles);
+
+	//Forget old paths, the navmesh or the goal may have changed since.
+	const double Now = FPlatformTime::Seconds();
+	const double CacheSeconds = CVarNavCacheSeconds.GetValueOnGameThread();
+	for(auto It = Cache.CreateIterator(); It; ++It)
+	{
+		if(Now - It->Value.Time > CacheSeconds)
+		{
+			It.RemoveCurrent();
+		}
+	}
+	//Dead AIs from earlier waves would otherwise keep their path until the level ends.
+	if(Now - LastAgentSweepTime > AgentSweepInterval)
+	{
+		LastAgentSweepTime = Now;
+		RemoveStaleAgents();
+	}
+
+	if(QueryOrder.Num() == 0)
+	{
+		return;
+	}
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = GetNavData();
+	if(!NavSys || !NavData)
+	{
+		return;
+	}
+
+	const int32 NumToIssue = FMath::Min(QueryOrder.Num(), FMath::Max(CVarNavQueriesPerFrame.GetValueOnGameThread(), 1));
+	for(int32 Index = 0; Index < NumToIssue; Index++)
+	{
+		const FPathKey& Key = QueryOrder[Index];
+		const FPendingQuery& Query = Pending.FindChecked(Key);
+		const FPathFindingQuery PathQuery(this, *NavData, Query.Start, Query.Goal);
+		const uint32 QueryId = NavSys->FindPathAsync(NavData->GetConfig(), PathQuery,
+			FNavPathQueryDelegate::CreateUObject(this, &ULeviathanNavigationSubsystem::OnPathFound));
+		InFlight.Add(QueryId, Key);
+	}
+	QueryOrder.RemoveAt(0, NumToIssue, false);
+	Stats.QueriesIssued += NumToIssue;
+	INC_DWORD_STAT_BY(STAT_NavigationQueriesIssued, NumToIssue);
+}
+
+void ULeviathanNavigationSubsystem::RemoveStaleAgents()
+{
+	for(auto It = Agents.CreateIterator(); It; ++It)
+	{
+		const AAIController* Controller = It->Key.Get();
+		if(!Controller || !Controller->GetPawn())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void ULeviathanNavigationSubsystem::OnPathFound(uint32 QueryId, ENavigationQueryResult::Type Result,
+	FNavPathSharedPtr Path)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NavigationPathFound);
+	FNavCycleScope CycleScope(Stats.GameThreadCycles);
+
+	FPathKey Key;
+	if(!InFlight.RemoveAndCopyValue(QueryId, Key))
+	{
+		return;
+	}
+	FPendingQuery Query;
+	if(!Pending.RemoveAndCopyValue(Key, Query))
+	{
+		return;
+	}
+
+	TArray<FVector> Points;
+	if(Result == ENavigationQueryResult::Success && Path.IsValid())
+	{
+		Points.Reserve(Path->GetPathPoints().Num());
+		for(const FNavPathPoint& Point : Path->GetPathPoints())
+		{
+			Points.Add(Point.Location);
+		}
+		if(Key.Get<2>() == 0)
+		{
+			FCachedPath& Cached = Cache.Add(Key);
+			Cached.Points = Points;
+			Cached.Time = FPlatformTime::Seconds();
+		}
+	}
+	for(FLeviathanPathReady& Waiter : Query.Waiters)
+	{
+		Waiter.ExecuteIfBound(Points);
+	}
+}
+
+void ULeviathanNavigationSubsystem::MoveAgentToActor(AAIController* Controller, AActor* Target, float AcceptanceRadius)
+{
+	if(Target)
+	{
+		MoveAgentTo(Controller, Target->GetActorLocation(), AcceptanceRadius);
+	}
+}
+
+void ULeviathanNavigationSubsystem::MoveAgentTo(AAIController* Controller, FVector Goal, float AcceptanceRadius)
+{
+	FNavCycleScope CycleScope(Stats.GameThreadCycles);
+	const APawn* Pawn = Controller ? Controller->GetPawn() : nullptr;
+	if(!Pawn)
+	{
+		return;
+	}
+	const FVector Start = Pawn->GetNavAgentLocation();
+	FAgentMove& Move = Agents.FindOrAdd(Controller);
+
+	//Still following our path, repair it rather than replanning.
+	const UPathFollowingComponent* PathFollowing = Controller->GetPathFollowingComponent();
+	if(Move.Path.IsValid() && PathFollowing && PathFollowing->GetPath() == Move.Path
+		&& PathFollowing->GetStatus() == EPathFollowingStatus::Moving)
+	{
+		if(FVector::DistSquared(Goal, Move.Goal) <= FMath::Square(AcceptanceRadius))
+		{
+			return;
+		}
+		TArray<FVector> Points = Move.Points;
+		if(TryRepair(Points, FMath::Max(int32(PathFollowing->GetCurrentPathIndex()), 0), Goal))
+		{
+			Points[0] = Start;
+			Move.Goal = Goal;
+			ApplyPath(Controller, MoveTemp(Points), AcceptanceRadius);
+			return;
+		}
+	}
+
+	Move.Goal = Goal;
+	QueuePath(Start, Goal, FLeviathanPathReady::CreateUObject(this, &ULeviathanNavigationSubsystem::OnAgentPathReady,
+		TWeakObjectPtr<AAIController>(Controller), AcceptanceRadius));
+}
+
+void ULeviathanNavigationSubsystem::OnAgentPathReady(const TArray<FVector>& Points,
+	TWeakObjectPtr<AAIController> Controller, float AcceptanceRadius)
+{
+	const APawn* Pawn = Controller.IsValid() ? Controller->GetPawn() : nullptr;
+	if(!Pawn)
+	{
+		//Died while the path was being found.
+		Agents.Remove(Controller);
+		return;
+	}
+	if(Points.Num() < 2)
+	{
+		return;
+	}
+	//A shared path starts where the agent that asked first stood.
+	TArray<FVector> AgentPoints = Points;
+	AgentPoints[0] = Pawn->GetNavAgentLocation();
+	ApplyPath(Controller.Get(), MoveTemp(AgentPoints), AcceptanceRadius);
+}
+
+void ULeviathanNavigationSubsystem::ApplyPath(AAIController* Controller, TArray<FVector>&& Points,
+	float AcceptanceRadius)
+{
+	FAgentMove& Move = Agents.FindOrAdd(Controller);
+	Move.Points = MoveTemp(Points);
+	Move.Path = MakeShareable(new FNavigationPath(Move.Points, nullptr));
+	Move.Path->SetNavigationDataUsed(GetNavData());
+
+	FAIMoveRequest Request(Move.Points.Last());
+	Request.SetAcceptanceRadius(AcceptanceRadius);
+	Controller->RequestMove(Request, Move.Path);
+}
+
+#if !UE_BUILD_SHIPPING
+/**Moves virtual agents (no pawns, no rendering, fine with -nullrhi) after a target circling the player and reports
+ * the path requests per second and the game thread time spent in the subsystem, for each agent count in turn.*/
+class FLeviathanNavBench : public TSharedFromThis<FLeviathanNavBench>
+{
+public:
+	TWeakObjectPtr<UWorld> World;
+	TArray<int32> AgentCounts;
+	float Seconds = 5.f;
+
+	void Start()
+	{
+		StartRun();
+		//The ticker holds the only reference, the bench is freed when Tick returns false.
+		TSharedRef<FLeviathanNavBench> This = AsShared();
+		FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([This](float DeltaTime)
+		{
+			return This->Tick(DeltaTime);
+		}));
+	}
+
+private:
+	static constexpr float RepathInterval = 0.25f;
+	static constexpr float AgentSpeed = 400.f;
+	static constexpr int32 PackSize = 8;
+
+	struct FAgent
+	{
+		FVector Location;
+		TArray<FVector> Points;
+		float NextRepath = 0.f;
+		bool bWaiting = false;
+	};
+
+	ULeviathanNavigationSubsystem* GetNavigation() const
+	{
+		return World.IsValid() ? World->GetSubsystem<ULeviathanNavigationSubsystem>() : nullptr;
+	}
+
+	void StartRun()
+	{
+		UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World.Get());
+		const APawn* Player = UGameplayStatics::GetPlayerPawn(World.Get(), 0);
+		Center = Player ? Player->GetActorLocation() : FVector::ZeroVector;
+
+		//Waves come in packs, place the agents in groups around a few random points.
+		Agents.Reset();
+		const int32 NumAgents = AgentCounts[RunIndex];
+		FNavLocation PackCenter;
+		for(int32 Index = 0; Index < NumAgents; Index++)
+		{
+			if(Index % PackSize == 0 && (!NavSys || !NavSys->GetRandomReachablePointInRadius(Center, 2500.f, PackCenter)))
+			{
+				PackCenter = FNavLocation(Center);
+			}
+			FNavLocation Location(PackCenter.Location);
+			if(NavSys)
+			{
+				NavSys->GetRandomReachablePointInRadius(PackCenter.Location, 200.f, Location);
+			}
+			FAgent& Agent = Agents.AddDefaulted_GetRef();
+			Agent.Location = Location.Location;
+			Agent.NextRepath = RepathInterval * Index / NumAgents;
+		}
+
+		if(const ULeviathanNavigationSubsystem* Navigation = GetNavigation())
+		{
+			StartStats = Navigation->GetStats();
+		}
+		Elapsed = 0.f;
+		Frames = 0;
+		WorstFrameMs = 0.0;
+	}
+
+	bool Tick(float DeltaTime)
+	{
+		ULeviathanNavigationSubsystem* Navigation = GetNavigation();
+		if(!Navigation)
+		{
+			return false;
+		}
+		const uint64 CyclesBefore = Navigation->GetStats().GameThreadCycles;
+		const float TargetAngle = Elapsed * 0.5f;
+		const FVector Target = Center + FVector(FMath::Cos(TargetAngle), FMath::Sin(TargetAngle), 0.f) * 800.f;
+
+		for(int32 Index = 0; Index < Agents.Num(); Index++)
+		{
+			FAgent& Agent = Agents[Index];
+			FollowPath(Agent, DeltaTime);
+			Agent.NextRepath -= DeltaTime;
+			if(Agent.NextRepath > 0.f || Agent.bWaiting)
+			{
+				continue;
+			}
+			Agent.NextRepath += RepathInterval;
+			if(Navigation->RepairPath(Agent.Points, 0, Target))
+			{
+				continue;
+			}
+			Agent.bWaiting = true;
+			TWeakPtr<FLeviathanNavBench> WeakThis = AsShared();
+			const int32 Run = RunIndex;
+			Navigation->RequestPath(Agent.Location, Target, FLeviathanPathReady::CreateLambda(
+				[WeakThis, Run, Index](const TArray<FVector>& Points)
+			{
+				TSharedPtr<FLeviathanNavBench> This = WeakThis.Pin();
+				if(This && This->RunIndex == Run && This->Agents.IsValidIndex(Index))
+				{
+					FAgent& Waiting = This->Agents[Index];
+					Waiting.bWaiting = false;
+					Waiting.Points = Points;
+					if(Waiting.Points.Num() > 0)
+					{
+						Waiting.Points[0] = Waiting.Location;
+					}
+				}
+			}));
+		}
+
+		//Agent updates above plus the subsystem tick and callbacks of the previous frame.
+		const double FrameMs = FPlatformTime::ToMilliseconds64(Navigation->GetStats().GameThreadCycles - CyclesBefore);
+		WorstFrameMs = FMath::Max(WorstFrameMs, FrameMs);
+		Frames++;
+		Elapsed += DeltaTime;
+		if(Elapsed < Seconds)
+		{
+			return true;
+		}
+
+		Report(Navigation->GetStats());
+		RunIndex++;
+		if(RunIndex < AgentCounts.Num())
+		{
+			StartRun();
+			return true;
+		}
+		return false;
+	}
+
+	void FollowPath(FAgent& Agent, float DeltaTime)
+	{
+		float Distance = AgentSpeed * DeltaTime;
+		while(Agent.Points.Num() >= 2 && Distance > 0.f)
+		{
+			const FVector ToNext = Agent.Points[1] - Agent.Location;
+			const float Length = ToNext.Size();
+			if(Length > Distance)
+			{
+				Agent.Location += ToNext / Length * Distance;
+				break;
+			}
+			Agent.Location = Agent.Points[1];
+			Agent.Points.RemoveAt(0, 1, false);
+			Distance -= Length;
+		}
+		if(Agent.Points.Num() > 0)
+		{
+			Agent.Points[0] = Agent.Location;
+		}
+	}
+
+	void Report(const FLeviathanNavStats& Stats) const
+	{
+		const int32 Requests = Stats.Requests - StartStats.Requests;
+		const int32 Repairs = Stats.Repairs - StartStats.Repairs;
+		const int32 Reused = Stats.CacheHits - StartStats.CacheHits + Stats.SharedQueries - StartStats.SharedQueries;
+		const int32 Queries = Stats.QueriesIssued - StartStats.QueriesIssued;
+		const double TotalMs = FPlatformTime::ToMilliseconds64(Stats.GameThreadCycles - StartStats.GameThreadCycles);
+		UE_LOG(LogLeviathan, Display, TEXT("Nav bench %d agents, %.1f s, sharing %s: %.0f requests/s (%.0f repairs/s, ")
+			TEXT("%.0f%% of requests reused a path), %.0f queries/s, game thread %.4f ms/frame avg, %.4f ms worst"),
+			Agents.Num(), Elapsed, CVarNavShare.GetValueOnGameThread() ? TEXT("on") : TEXT("off"),
+			(Requests + Repairs) / Elapsed, Repairs / Elapsed, Requests > 0 ? 100.f * Reused / Requests : 0.f,
+			Queries / Elapsed, Frames > 0 ? TotalMs / Frames : 0.0, WorstFrameMs);
+	}
+
+	TArray<FAgent> Agents;
+	int32 RunIndex = 0;
+	FVector Center = FVector::ZeroVector;
+	FLeviathanNavStats StartStats;
+	float Elapsed = 0.f;
+	int32 Frames = 0;
+	double WorstFrameMs = 0.0;
+};
+
+/**Leviathan.Nav.Bench [Agents=50,200] [Seconds=5]
+ * Run headless with -game -nullrhi -ExecCmds="Leviathan.Nav.Bench", and again with Leviathan.Nav.Share 0 to compare.*/
+static FAutoConsoleCommandWithWorldAndArgs NavBenchCommand(
+	TEXT("Leviathan.Nav.Bench"),
+	TEXT("Chases a moving target with virtual agents and logs requests/s and game thread cost. Agents=50,200 Seconds=5."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if(!World || !World->GetSubsystem<ULeviathanNavigationSubsystem>())
+		{
+			return;
+		}
+		TSharedRef<FLeviathanNavBench> Bench = MakeShared<FLeviathanNavBench>();
+		Bench->World = World;
+		FString AgentList = TEXT("50,200");
+		for(const FString& Arg : Args)
+		{
+			FParse::Value(*Arg, TEXT("Agents="), AgentList, false);
+			FParse::Value(*Arg, TEXT("Seconds="), Bench->Seconds);
+		}
+		TArray<FString> Counts;
+		AgentList.ParseIntoArray(Counts, TEXT(","));
+		for(const FString& Count : Counts)
+		{
+			Bench->AgentCounts.Add(FMath::Max(FCString::Atoi(*Count), 1));
+		}
+		if(Bench->AgentCounts.Num() == 0)
+		{
+			return;
+		}
+		Bench->Start();
+	}));
+#endif
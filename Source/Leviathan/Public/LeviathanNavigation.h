@@ -0,0 +1,114 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+
+#include "LeviathanNavigation.generated.h"
+
+class AAIController;
+class ANavigationData;
+
+//Path points from start to goal, empty if no path was found.
+DECLARE_DELEGATE_OneParam(FLeviathanPathReady, const TArray<FVector>& /*Points*/);
+
+//Counters since the subsystem started, read by Leviathan.Nav.Bench.
+struct FLeviathanNavStats
+{
+	int32 Requests = 0;
+	//Requests answered by a cached path or by joining a query already queued for the same regions.
+	int32 CacheHits = 0;
+	int32 SharedQueries = 0;
+	int32 Repairs = 0;
+	int32 QueriesIssued = 0;
+	uint64 GameThreadCycles = 0;
+};
+
+/**Path requests for AI_Master agents. Instead of every agent pathfinding on its own frame:
+ * - requests are grouped by start and goal region (Leviathan.Nav.RegionSize) and agents in the same regions share one
+ *   query, or the cached result of the last one for Leviathan.Nav.CacheSeconds
+ * - queries are run by the navigation system on a worker thread, at most Leviathan.Nav.QueriesPerFrame issued a frame
+ * - when the goal moves less than Leviathan.Nav.RepairDistance the current path is spliced to the new goal from the
+ *   last point that can see it on the navmesh, and only replanned if none can
+ */
+UCLASS()
+class LEVIATHAN_API ULeviathanNavigationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	//Moves the controlled pawn to Goal along a shared or repaired path. Call it again whenever the goal moves.
+	UFUNCTION(BlueprintCallable, Category = Navigation)
+	void MoveAgentTo(AAIController* Controller, FVector Goal, float AcceptanceRadius = 50.f);
+	UFUNCTION(BlueprintCallable, Category = Navigation)
+	void MoveAgentToActor(AAIController* Controller, AActor* Target, float AcceptanceRadius = 50.f);
+
+	//Finds a path on the default navmesh, OnReady is called on the game thread, right away on a cache hit.
+	void RequestPath(const FVector& Start, const FVector& Goal, FLeviathanPathReady OnReady);
+
+	/**Splices Points to end at NewGoal, dropping the points before FirstPoint.
+	 * @return false if no point near the end can see NewGoal, replan then*/
+	bool RepairPath(TArray<FVector>& Points, int32 FirstPoint, const FVector& NewGoal);
+
+	const FLeviathanNavStats& GetStats() const { return Stats; }
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return QueryOrder.Num() > 0 || Cache.Num() > 0 || Agents.Num() > 0; }
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+private:
+	//Start region, goal region, and a unique id when sharing is turned off.
+	using FPathKey = TTuple<FIntVector, FIntVector, uint32>;
+
+	struct FPendingQuery
+	{
+		FVector Start;
+		FVector Goal;
+		TArray<FLeviathanPathReady> Waiters;
+	};
+
+	struct FCachedPath
+	{
+		TArray<FVector> Points;
+		double Time = 0.0;
+	};
+
+	struct FAgentMove
+	{
+		FVector Goal = FVector::ZeroVector;
+		TArray<FVector> Points;
+		FNavPathSharedPtr Path;
+	};
+
+	FPathKey MakeKey(const FVector& Start, const FVector& Goal);
+	void QueuePath(const FVector& Start, const FVector& Goal, FLeviathanPathReady OnReady);
+	bool TryRepair(TArray<FVector>& Points, int32 FirstPoint, const FVector& NewGoal);
+	void OnPathFound(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+	void OnAgentPathReady(const TArray<FVector>& Points, TWeakObjectPtr<AAIController> Controller,
+		float AcceptanceRadius);
+	void ApplyPath(AAIController* Controller, TArray<FVector>&& Points, float AcceptanceRadius);
+	ANavigationData* GetNavData() const;
+	//Drops agents whose controller is gone or no longer has a pawn.
+	void RemoveStaleAgents();
+
+	TMap<FPathKey, FPendingQuery> Pending;
+	//Keys not issued yet, oldest first.
+	TArray<FPathKey> QueryOrder;
+	TMap<uint32, FPathKey> InFlight;
+	TMap<FPathKey, FCachedPath> Cache;
+	TMap<TWeakObjectPtr<AAIController>, FAgentMove> Agents;
+	static constexpr double AgentSweepInterval = 1.0;
+	double LastAgentSweepTime = 0.0;
+	uint32 NextUniqueKey = 1;
+
+	FLeviathanNavStats Stats;
+};
@@ -0,0 +1,132 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanPerfBudget.h"
+
+#include "Leviathan.h"
+#include "Dom/JsonObject.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+FLeviathanPerfBudget& FLeviathanPerfBudget::Get()
+{
+	static FLeviathanPerfBudget Instance;
+	return Instance;
+}
+
+void FLeviathanPerfBudget::Record(FName Function, uint64 Cycles)
+{
+	//Only the game thread is measured, anything else would need locking.
+	if(!IsInGameThread())
+	{
+		return;
+	}
+	const double Ms = FPlatformTime::ToMilliseconds64(Cycles);
+	FLeviathanPerfSample& Sample = Samples.FindOrAdd(Function);
+	Sample.Calls++;
+	Sample.TotalMs += Ms;
+	Sample.MaxMs = FMath::Max(Sample.MaxMs, Ms);
+}
+
+void FLeviathanPerfBudget::Reset()
+{
+	Samples.Reset();
+}
+
+bool FLeviathanPerfBudget::WriteReport(float MarginPercent, FString& OutReportPath) const
+{
+	const ULeviathanPerfSettings* Settings = GetDefault<ULeviathanPerfSettings>();
+	const float MarginScale = 1.f + MarginPercent / 100.f;
+	bool bPassed = true;
+
+	TArray<TSharedPtr<FJsonValue>> Functions;
+	//Go through the budgets so a function that was never called still shows up in the report.
+	TSet<FName> Names;
+	Settings->FunctionBudgetsMs.GetKeys(Names);
+	for(const TPair<FName, FLeviathanPerfSample>& Pair : Samples)
+	{
+		Names.Add(Pair.Key);
+	}
+
+	for(const FName& Name : Names)
+	{
+		const FLeviathanPerfSample* Sample = Samples.Find(Name);
+		const float* Budget = Settings->FunctionBudgetsMs.Find(Name);
+		const double MaxMs = Sample ? Sample->MaxMs : 0.0;
+		const bool bOverBudget = Budget && MaxMs > *Budget * MarginScale;
+
+		TSharedPtr<FJsonObject> Entry = MakeShared<FJsonObject>();
+		Entry->SetStringField(TEXT("name"), Name.ToString());
+		Entry->SetNumberField(TEXT("calls"), Sample ? Sample->Calls : 0);
+		Entry->SetNumberField(TEXT("avgMs"), Sample && Sample->Calls > 0 ? Sample->TotalMs / Sample->Calls : 0.0);
+		Entry->SetNumberField(TEXT("maxMs"), MaxMs);
+		Entry->SetNumberField(TEXT("budgetMs"), Budget ? *Budget : -1.f);
+		Entry->SetBoolField(TEXT("overBudget"), bOverBudget);
+		Functions.Add(MakeShared<FJsonValueObject>(Entry));
+
+		if(bOverBudget)
+		{
+			UE_LOG(LogLeviathan, Error, TEXT("%s took %.4f ms, budget is %.4f ms (+%.1f%%)"), *Name.ToString(), MaxMs,
+				*Budget, MarginPercent);
+			bPassed = false;
+		}
+	}
+
+	TSharedPtr<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+	Report->SetNumberField(TEXT("marginPercent"), MarginPercent);
+	Report->SetBoolField(TEXT("passed"), bPassed);
+	Report->SetArrayField(TEXT("functions"), Functions);
+
+	FString Output;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Output);
+	FJsonSerializer::Serialize(Report.ToSharedRef(), Writer);
+
+	OutReportPath = FPaths::Combine(FPaths::ProjectSavedDir(), Settings->ReportFolder,
+		FString::Printf(TEXT("AxePerf-%s.json"), *FDateTime::Now().ToString()));
+	if(!FFileHelper::SaveStringToFile(Output, *OutReportPath))
+	{
+		UE_LOG(LogLeviathan, Error, TEXT("Could not write perf report to %s"), *OutReportPath);
+		return false;
+	}
+	return bPassed;
+}
+
+#if LEVIATHAN_PERF_BUDGETS
+static FAutoConsoleCommand PerfResetCommand(
+	TEXT("Leviathan.Perf.Reset"),
+	TEXT("Clears the timings collected for the axe perf budgets."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FLeviathanPerfBudget::Get().Reset();
+	}));
+
+static FAutoConsoleCommand PerfReportCommand(
+	TEXT("Leviathan.Perf.Report"),
+	TEXT("Writes the axe perf budget report. Margin=<percent> overrides the configured margin, ")
+	TEXT("Exit quits with a non zero code if a budget was exceeded (for -nullrhi runs)."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		float MarginPercent = GetDefault<ULeviathanPerfSettings>()->BudgetMarginPercent;
+		bool bExit = false;
+		for(const FString& Arg : Args)
+		{
+			FParse::Value(*Arg, TEXT("Margin="), MarginPercent);
+			bExit |= Arg.Equals(TEXT("Exit"), ESearchCase::IgnoreCase);
+		}
+
+		FString ReportPath;
+		const bool bPassed = FLeviathanPerfBudget::Get().WriteReport(MarginPercent, ReportPath);
+		UE_LOG(LogLeviathan, Display, TEXT("Axe perf report %s: %s"), bPassed ? TEXT("passed") : TEXT("FAILED"),
+			*ReportPath);
+
+		if(bExit)
+		{
+			FPlatformMisc::RequestExitWithStatus(false, bPassed ? 0 : 1);
+		}
+	}));
+#endif
@@ -0,0 +1,92 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+
+#include "LeviathanPerfBudget.generated.h"
+
+//Budgets are only measured in non shipping builds, the scopes compile out completely in Shipping.
+#define LEVIATHAN_PERF_BUDGETS !UE_BUILD_SHIPPING
+
+/**Per function game thread budgets for the axe lifecycle. Edit them in Project Settings > Game > Leviathan Perf Budgets
+ * or in DefaultGame.ini. The report fails when a function goes over its budget by more than the margin.*/
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Leviathan Perf Budgets"))
+class LEVIATHAN_API ULeviathanPerfSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	//Worst case milliseconds a single call of the function is allowed to take on the game thread.
+	UPROPERTY(config, EditAnywhere, Category = "Budgets")
+	TMap<FName, float> FunctionBudgetsMs;
+	//How much (in percent) a function can go over its budget before the report fails.
+	UPROPERTY(config, EditAnywhere, Category = "Budgets", meta = (ClampMin = "0.0"))
+	float BudgetMarginPercent = 10.f;
+	//Peak megabytes each Leviathan LLM tag is allowed to reach (see Leviathan.Memory.Report).
+	UPROPERTY(config, EditAnywhere, Category = "Budgets")
+	TMap<FName, float> MemoryBudgetsMB;
+	//Milliseconds per frame ULeviathanWaveSpawnerSubsystem may spend spawning. Also give SpawnFrame a function budget.
+	UPROPERTY(config, EditAnywhere, Category = "Budgets", meta = (ClampMin = "0.1"))
+	float SpawnBudgetMsPerFrame = 1.f;
+	//Folder the report is written to, relative to the project Saved folder.
+	UPROPERTY(config, EditAnywhere, Category = "Report")
+	FString ReportFolder = TEXT("Profiling/Leviathan");
+};
+
+//Timings collected for one function.
+struct FLeviathanPerfSample
+{
+	int32 Calls = 0;
+	double TotalMs = 0.0;
+	double MaxMs = 0.0;
+};
+
+/**Collects the game thread time spent in the instrumented functions and writes it out as a json report
+ * checked against the budgets in ULeviathanPerfSettings.
+ * Console commands: Leviathan.Perf.Reset, Leviathan.Perf.Report [Margin=<percent>] [Exit]
+ */
+class LEVIATHAN_API FLeviathanPerfBudget
+{
+public:
+	static FLeviathanPerfBudget& Get();
+
+	void Record(FName Function, uint64 Cycles);
+	void Reset();
+	const TMap<FName, FLeviathanPerfSample>& GetSamples() const { return Samples; }
+
+	/**Writes the report to disk.
+	 * @return true if every function stayed inside its budget (plus margin)*/
+	bool WriteReport(float MarginPercent, FString& OutReportPath) const;
+
+private:
+	TMap<FName, FLeviathanPerfSample> Samples;
+};
+
+//Scope that measures the time spent until it goes out of scope.
+class FLeviathanPerfScope
+{
+public:
+	explicit FLeviathanPerfScope(FName InFunction)
+		: Function(InFunction)
+		, StartCycles(FPlatformTime::Cycles64())
+	{
+	}
+	~FLeviathanPerfScope()
+	{
+		FLeviathanPerfBudget::Get().Record(Function, FPlatformTime::Cycles64() - StartCycles);
+	}
+
+private:
+	FName Function;
+	uint64 StartCycles;
+};
+
+#if LEVIATHAN_PERF_BUDGETS
+#define LEVIATHAN_PERF_SCOPE(Name) \
+	static const FName PerfScopeName_##Name(TEXT(#Name)); \
+	FLeviathanPerfScope PerfScope_##Name(PerfScopeName_##Name)
+#else
+#define LEVIATHAN_PERF_SCOPE(Name)
+#endif
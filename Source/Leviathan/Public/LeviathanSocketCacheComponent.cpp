@@ -0,0 +1,142 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanSocketCacheComponent.h"
+
+#include "Leviathan.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "GameFramework/Character.h"
+
+DECLARE_CYCLE_STAT(TEXT("SocketCache Snapshot"), STAT_SocketCacheSnapshot, STATGROUP_Leviathan);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SocketCache Late Snapshots"), STAT_SocketCacheLateSnapshots, STATGROUP_Leviathan);
+
+const FName ULeviathanSocketCacheComponent::AxeSocketName(TEXT("AxeSocket"));
+const FName ULeviathanSocketCacheComponent::HandSocketName(TEXT("RightHandWeaponBoneSocket"));
+
+ULeviathanSocketCacheComponent::ULeviathanSocketCacheComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+
+	SocketNames.Add(AxeSocketName);
+	SocketNames.Add(HandSocketName);
+}
+
+void ULeviathanSocketCacheComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	const ACharacter* Character = Cast<ACharacter>(GetOwner());
+	Mesh = Character ? Character->GetMesh() : GetOwner()->FindComponentByClass<USkeletalMeshComponent>();
+	if(Mesh)
+	{
+		//The mesh tick only completes once the (parallel) animation is evaluated and the bones are final.
+		PrimaryComponentTick.AddPrerequisite(Mesh, Mesh->PrimaryComponentTick);
+	}
+	Resolve();
+	Snapshot();
+}
+
+void ULeviathanSocketCacheComponent::AddReader(FTickFunction& ReaderTick)
+{
+	ReaderTick.AddPrerequisite(this, PrimaryComponentTick);
+}
+
+void ULeviathanSocketCacheComponent::AddReaderActor(AActor* Reader)
+{
+	if(!Reader)
+	{
+		return;
+	}
+	AddReader(Reader->PrimaryActorTick);
+	//Blueprint timelines are components, they call UpdateReturnAxePosition from their own tick.
+	for(UActorComponent* Component : Reader->GetComponents())
+	{
+		if(Component && Component->PrimaryComponentTick.bCanEverTick)
+		{
+			AddReader(Component->PrimaryComponentTick);
+		}
+	}
+}
+
+void ULeviathanSocketCacheComponent::Resolve()
+{
+	Resolved.Reset();
+	Resolved.SetNum(SocketNames.Num());
+	Transforms.Init(FTransform::Identity, SocketNames.Num());
+	ResolvedMesh = Mesh ? Mesh->SkeletalMesh : nullptr;
+	if(!ResolvedMesh.IsValid())
+	{
+		return;
+	}
+	for(int32 Index = 0; Index < SocketNames.Num(); Index++)
+	{
+		FResolvedSocket& Socket = Resolved[Index];
+		if(const USkeletalMeshSocket* MeshSocket = ResolvedMesh->FindSocket(SocketNames[Index]))
+		{
+			Socket.BoneIndex = Mesh->GetBoneIndex(MeshSocket->BoneName);
+			Socket.LocalTransform = MeshSocket->GetSocketLocalTransform();
+		}
+		else
+		{
+			Socket.BoneIndex = Mesh->GetBoneIndex(SocketNames[Index]);
+		}
+		if(Socket.BoneIndex == INDEX_NONE)
+		{
+			UE_LOG(LogLeviathan, Warning, TEXT("%s: no socket or bone %s on %s"), *GetName(),
+				*SocketNames[Index].ToString(), *ResolvedMesh->GetName());
+		}
+	}
+}
+
+void ULeviathanSocketCacheComponent::Snapshot()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SocketCacheSnapshot);
+	SnapshotFrame = GFrameCounter;
+	if(!Mesh)
+	{
+		return;
+	}
+	if(Mesh->SkeletalMesh != ResolvedMesh.Get())
+	{
+		Resolve();
+	}
+	const TArray<FTransform>& ComponentSpace = Mesh->GetComponentSpaceTransforms();
+	const FTransform& ComponentToWorld = Mesh->GetComponentTransform();
+	for(int32 Index = 0; Index < Resolved.Num(); Index++)
+	{
+		const FResolvedSocket& Socket = Resolved[Index];
+		if(ComponentSpace.IsValidIndex(Socket.BoneIndex))
+		{
+			Transforms[Index] = Socket.LocalTransform * ComponentSpace[Socket.BoneIndex] * ComponentToWorld;
+		}
+		else
+		{
+			Transforms[Index] = ComponentToWorld;
+		}
+	}
+}
+
+void ULeviathanSocketCacheComponent::TickComponent(float DeltaTime, ELevelTick TickType,
+	FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	Snapshot();
+}
+
+const FTransform& ULeviathanSocketCacheComponent::GetTransform(int32 SocketIndex)
+{
+	if(SnapshotFrame != GFrameCounter)
+	{
+		//Read before this frame's tick (input, overlaps), take the pose the mesh has right now.
+		INC_DWORD_STAT(STAT_SocketCacheLateSnapshots);
+		Snapshot();
+	}
+	return Transforms.IsValidIndex(SocketIndex) ? Transforms[SocketIndex] : FTransform::Identity;
+}
+
+FTransform ULeviathanSocketCacheComponent::GetSocketTransform(FName SocketName)
+{
+	return GetTransform(FindSocketIndex(SocketName));
+}
@@ -0,0 +1,69 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+
+#include "LeviathanSocketCacheComponent.generated.h"
+
+/**World transforms of a few sockets of the owner's skeletal mesh, taken once per frame right after the mesh finished
+ * animating and shared by everything that needs them (the returning axe reads AxeSocket every frame).
+ * Socket and bone indexes are resolved once instead of a name search per call. The tick has the mesh tick as
+ * prerequisite, and readers that tick call AddReader so they run after the snapshot. A read from anywhere else that
+ * comes before this frame's snapshot refreshes it, so it returns what GetSocketTransform would.
+ */
+UCLASS(ClassGroup = (Axe), meta = (BlueprintSpawnableComponent))
+class LEVIATHAN_API ULeviathanSocketCacheComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	ULeviathanSocketCacheComponent();
+
+	static const FName AxeSocketName;
+	static const FName HandSocketName;
+
+	//Sockets (or bones) cached. Indexes into this are what GetTransform takes.
+	UPROPERTY(EditDefaultsOnly, Category = Sockets)
+	TArray<FName> SocketNames;
+
+	//Index to pass to GetTransform, INDEX_NONE if the name is not cached.
+	int32 FindSocketIndex(FName SocketName) const { return SocketNames.IndexOfByKey(SocketName); }
+
+	//World transform of the socket this frame.
+	const FTransform& GetTransform(int32 SocketIndex);
+
+	UFUNCTION(BlueprintPure, Category = Sockets)
+	FTransform GetSocketTransform(FName SocketName);
+
+	//Makes ReaderTick run after the snapshot of every frame.
+	void AddReader(FTickFunction& ReaderTick);
+	//Adds the actor tick and every component tick of Reader.
+	void AddReaderActor(AActor* Reader);
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
+		FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	struct FResolvedSocket
+	{
+		int32 BoneIndex = INDEX_NONE;
+		//Socket offset from its bone, identity when the name is a bone.
+		FTransform LocalTransform;
+	};
+
+	void Resolve();
+	void Snapshot();
+
+	UPROPERTY(Transient)
+	class USkeletalMeshComponent* Mesh;
+	//Mesh asset the indexes were resolved for, resolved again if it changes.
+	TWeakObjectPtr<class USkeletalMesh> ResolvedMesh;
+	TArray<FResolvedSocket> Resolved;
+	TArray<FTransform> Transforms;
+	uint64 SnapshotFrame = 0;
+};
@@ -0,0 +1,192 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanTelemetry.h"
+
+#include "Leviathan.h"
+#include "LeviathanAxe.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Telemetry RecordAxeEvent"), STAT_TelemetryRecordAxeEvent, STATGROUP_Leviathan);
+
+//What recording one event may cost the game thread.
+static constexpr double TelemetryRecordBudgetNs = 1000.0;
+
+static TAutoConsoleVariable<int32> CVarTelemetryEnable(
+	TEXT("Leviathan.Telemetry.Enable"),
+	0,
+	TEXT("Record every axe throw to Saved/Telemetry. Read when the game instance starts."));
+
+static TAutoConsoleVariable<float> CVarTelemetryFlushInterval(
+	TEXT("Leviathan.Telemetry.FlushInterval"),
+	0.25f,
+	TEXT("Seconds between flushes of the telemetry ring buffer to disk."));
+
+FLeviathanTelemetryWriter::FLeviathanTelemetryWriter(const FString& InFilename, uint32 Capacity)
+	: Filename(InFilename)
+	, Queue(Capacity)
+{
+	Header.StartSeconds = FPlatformTime::Seconds();
+	Archive = IFileManager::Get().CreateFileWriter(*Filename);
+	if(Archive)
+	{
+		*Archive << Header;
+		Thread = FRunnableThread::Create(this, TEXT("LeviathanTelemetryWriter"), 0, TPri_BelowNormal);
+	}
+	else
+	{
+		UE_LOG(LogLeviathan, Error, TEXT("Could not open telemetry file %s"), *Filename);
+	}
+}
+
+FLeviathanTelemetryWriter::~FLeviathanTelemetryWriter()
+{
+	if(Thread)
+	{
+		//Kill waits for Run to return, which drains whatever is left in the ring.
+		Thread->Kill(true);
+		delete Thread;
+	}
+	if(Archive)
+	{
+		Archive->Close();
+		delete Archive;
+	}
+	if(DroppedEvents.GetValue() > 0)
+	{
+		UE_LOG(LogLeviathan, Warning, TEXT("Telemetry dropped %d events, the ring buffer was full"),
+			DroppedEvents.GetValue());
+	}
+}
+
+uint32 FLeviathanTelemetryWriter::Run()
+{
+	while(!bStopping)
+	{
+		Drain();
+		FPlatformProcess::Sleep(FMath::Max(CVarTelemetryFlushInterval.GetValueOnAnyThread(), 0.01f));
+	}
+	Drain();
+	return 0;
+}
+
+void FLeviathanTelemetryWriter::Drain()
+{
+	bool bWrote = false;
+	FLeviathanTelemetryEvent Event;
+	while(Queue.Dequeue(Event))
+	{
+		*Archive << Event;
+		bWrote = true;
+	}
+	if(bWrote)
+	{
+		Archive->Flush();
+	}
+}
+
+void ULeviathanTelemetrySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if(CVarTelemetryEnable.GetValueOnGameThread() != 0)
+	{
+		const FString Filename = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Telemetry"),
+			FString::Printf(TEXT("Throws-%s.levtel"), *FDateTime::Now().ToString()));
+		Writer = MakeUnique<FLeviathanTelemetryWriter>(Filename, 4096);
+		UE_LOG(LogLeviathan, Log, TEXT("Recording throw telemetry to %s"), *Filename);
+	}
+}
+
+void ULeviathanTelemetrySubsystem::Deinitialize()
+{
+	Writer.Reset();
+	Super::Deinitialize();
+}
+
+void ULeviathanTelemetrySubsystem::RecordAxeEvent(ELeviathanAxeTraceEvent Type, const ALeviathanAxe* Axe)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TelemetryRecordAxeEvent);
+	const double Now = FPlatformTime::Seconds();
+
+	FLeviathanTelemetryEvent Event;
+	Event.Time = Now - Writer->GetStartSeconds();
+	Event.AxeId = Axe->GetUniqueID();
+	Event.Type = Type;
+	Event.ThrowOrigin = Axe->ThrowCameraLocation;
+	Event.ThrowDirection = Axe->ThrowDirection;
+
+	switch(Type)
+	{
+		case ELeviathanAxeTraceEvent::Lodge:
+			Event.Surface = Axe->ESurfaceHit;
+			Event.FlightTime = float(Now - Axe->ThrowTimeSeconds);
+			break;
+		case ELeviathanAxeTraceEvent::Recall:
+			Event.Surface = Axe->ESurfaceHit;
+			Event.FlightTime = float(Now - Axe->ThrowTimeSeconds);
+			Event.DistanceFromCharacter = Axe->DistanceFromCharacter;
+			break;
+		case ELeviathanAxeTraceEvent::Catch:
+			Event.SpinCount = uint8(FMath::Clamp(Axe->TotalReturnSpins, 0, 255));
+			Event.ReturnDuration = float(Now - Axe->RecallTimeSeconds);
+			break;
+		default:
+			break;
+	}
+	Writer->Record(Event);
+}
+
+#if !UE_BUILD_SHIPPING
+double ULeviathanTelemetrySubsystem::BenchRecord(const ALeviathanAxe* Axe, int32 NumEvents)
+{
+	//A ring big enough for every event, so none are dropped, which would be cheaper than recording them.
+	const FString Filename = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Telemetry"), TEXT("Bench.levtel"));
+	TUniquePtr<FLeviathanTelemetryWriter> Recording = MoveTemp(Writer);
+	Writer = MakeUnique<FLeviathanTelemetryWriter>(Filename, uint32(NumEvents) + 1);
+
+	static const ELeviathanAxeTraceEvent Types[] = { ELeviathanAxeTraceEvent::Throw, ELeviathanAxeTraceEvent::Lodge,
+		ELeviathanAxeTraceEvent::Recall, ELeviathanAxeTraceEvent::Catch };
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	for(int32 Index = 0; Index < NumEvents; Index++)
+	{
+		RecordAxeEvent(Types[Index % UE_ARRAY_COUNT(Types)], Axe);
+	}
+	const double Ms = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	Writer = MoveTemp(Recording);
+	IFileManager::Get().Delete(*Filename);
+	return Ms * 1000000.0 / NumEvents;
+}
+
+/**Leviathan.Telemetry.Bench [Events=10000]
+ * Records Events throw events into a scratch file and logs the game thread cost of each against its budget.*/
+static FAutoConsoleCommandWithWorldAndArgs TelemetryBenchCommand(
+	TEXT("Leviathan.Telemetry.Bench"),
+	TEXT("Logs nanoseconds per recorded telemetry event against the 1 us budget. Events=10000."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		ULeviathanTelemetrySubsystem* Telemetry = GameInstance
+			? GameInstance->GetSubsystem<ULeviathanTelemetrySubsystem>() : nullptr;
+		if(!Telemetry)
+		{
+			return;
+		}
+		int32 NumEvents = 10000;
+		for(const FString& Arg : Args)
+		{
+			FParse::Value(*Arg, TEXT("Events="), NumEvents);
+		}
+		NumEvents = FMath::Max(NumEvents, 1);
+
+		const double Ns = Telemetry->BenchRecord(GetDefault<ALeviathanAxe>(), NumEvents);
+		UE_LOG(LogLeviathan, Display, TEXT("Telemetry bench: %d events, %.1f ns per event, budget %.0f ns (%s)"),
+			NumEvents, Ns, TelemetryRecordBudgetNs, Ns <= TelemetryRecordBudgetNs ? TEXT("ok") : TEXT("over"));
+	}));
+#endif
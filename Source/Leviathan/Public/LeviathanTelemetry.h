@@ -0,0 +1,123 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/CircularQueue.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "LeviathanTrace.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Templates/Atomic.h"
+
+#include "LeviathanTelemetry.generated.h"
+
+//File layout: FLeviathanTelemetryHeader followed by FLeviathanTelemetryEvent records until the end of the file.
+#define LEVIATHAN_TELEMETRY_MAGIC 0x4C54564C //"LVTL"
+#define LEVIATHAN_TELEMETRY_VERSION 1
+
+struct FLeviathanTelemetryHeader
+{
+	uint32 Magic = LEVIATHAN_TELEMETRY_MAGIC;
+	uint32 Version = LEVIATHAN_TELEMETRY_VERSION;
+	//FPlatformTime::Seconds when recording started, event times are relative to it.
+	double StartSeconds = 0.0;
+
+	friend FArchive& operator<<(FArchive& Ar, FLeviathanTelemetryHeader& Header)
+	{
+		return Ar << Header.Magic << Header.Version << Header.StartSeconds;
+	}
+};
+
+//One throw lifecycle event. Not every field is meaningful for every event type.
+struct FLeviathanTelemetryEvent
+{
+	//Seconds since recording started.
+	double Time = 0.0;
+	uint32 AxeId = 0;
+	ELeviathanAxeTraceEvent Type = ELeviathanAxeTraceEvent::Throw;
+	//EPhysicalSurface of the lodge (Lodge/Recall).
+	uint8 Surface = 0;
+	//Spins the axe did on the way back (Catch).
+	uint8 SpinCount = 0;
+	//Camera location and forward vector when thrown.
+	FVector ThrowOrigin = FVector::ZeroVector;
+	FVector ThrowDirection = FVector::ZeroVector;
+	//Seconds from throw to lodge (Lodge), or from throw to recall (Recall).
+	float FlightTime = 0.f;
+	//DistanceFromCharacter when recalled (Recall).
+	float DistanceFromCharacter = 0.f;
+	//Seconds from recall to catch (Catch).
+	float ReturnDuration = 0.f;
+
+	friend FArchive& operator<<(FArchive& Ar, FLeviathanTelemetryEvent& Event)
+	{
+		uint8 Type = uint8(Event.Type);
+		Ar << Event.Time << Event.AxeId << Type << Event.Surface << Event.SpinCount << Event.ThrowOrigin
+			<< Event.ThrowDirection << Event.FlightTime << Event.DistanceFromCharacter << Event.ReturnDuration;
+		Event.Type = ELeviathanAxeTraceEvent(Type);
+		return Ar;
+	}
+};
+
+/**Append-only binary writer. The game thread pushes events into a lock-free single producer/single consumer ring
+ * buffer and a background thread drains it to disk, so recording is a copy into the ring and nothing else.*/
+class FLeviathanTelemetryWriter : public FRunnable
+{
+public:
+	FLeviathanTelemetryWriter(const FString& InFilename, uint32 Capacity);
+	virtual ~FLeviathanTelemetryWriter();
+
+	//Game thread only. Drops the event (and counts it) if the ring is full.
+	FORCEINLINE void Record(const FLeviathanTelemetryEvent& Event)
+	{
+		if(!Queue.Enqueue(Event))
+		{
+			DroppedEvents.Increment();
+		}
+	}
+
+	double GetStartSeconds() const { return Header.StartSeconds; }
+	int32 GetDroppedEvents() const { return DroppedEvents.GetValue(); }
+	const FString& GetFilename() const { return Filename; }
+
+	//FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override { bStopping = true; }
+
+private:
+	void Drain();
+
+	FString Filename;
+	FLeviathanTelemetryHeader Header;
+	TCircularQueue<FLeviathanTelemetryEvent> Queue;
+	FArchive* Archive = nullptr;
+	FRunnableThread* Thread = nullptr;
+	FThreadSafeCounter DroppedEvents;
+	TAtomic<bool> bStopping { false };
+};
+
+/**Records every throw (Throw, LodgeAxe, SetupTimelineReturn and CatchAxe) to Saved/Telemetry when
+ * Leviathan.Telemetry.Enable is 1 at game start. Read the files with the LeviathanTelemetryReader commandlet.*/
+UCLASS()
+class LEVIATHAN_API ULeviathanTelemetrySubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	bool IsRecording() const { return Writer.IsValid(); }
+
+	//Fills an event from the current state of the axe and queues it.
+	void RecordAxeEvent(ELeviathanAxeTraceEvent Type, const class ALeviathanAxe* Axe);
+
+#if !UE_BUILD_SHIPPING
+	//Records NumEvents events of Axe into a scratch file and returns the mean nanoseconds per event.
+	double BenchRecord(const class ALeviathanAxe* Axe, int32 NumEvents);
+#endif
+
+private:
+	TUniquePtr<FLeviathanTelemetryWriter> Writer;
+};
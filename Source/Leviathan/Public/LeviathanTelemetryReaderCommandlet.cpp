@@ -0,0 +1,115 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanTelemetryReaderCommandlet.h"
+
+#include "Leviathan.h"
+#include "LeviathanTelemetry.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+
+static const TCHAR* GetEventName(ELeviathanAxeTraceEvent Type)
+{
+	switch(Type)
+	{
+		case ELeviathanAxeTraceEvent::Throw: return TEXT("Throw");
+		case ELeviathanAxeTraceEvent::Lodge: return TEXT("Lodge");
+		case ELeviathanAxeTraceEvent::Recall: return TEXT("Recall");
+		case ELeviathanAxeTraceEvent::Catch: return TEXT("Catch");
+		default: return TEXT("Unknown");
+	}
+}
+
+ULeviathanTelemetryReaderCommandlet::ULeviathanTelemetryReaderCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 ULeviathanTelemetryReaderCommandlet::Main(const FString& Params)
+{
+	FString Filename;
+	if(!FParse::Value(*Params, TEXT("File="), Filename))
+	{
+		UE_LOG(LogLeviathan, Error, TEXT("Usage: -run=LeviathanTelemetryReader -File=<file.levtel> [-Csv=<out.csv>]"));
+		return 1;
+	}
+
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+	if(!Reader)
+	{
+		UE_LOG(LogLeviathan, Error, TEXT("Could not open %s"), *Filename);
+		return 1;
+	}
+
+	FLeviathanTelemetryHeader Header;
+	*Reader << Header;
+	if(Header.Magic != LEVIATHAN_TELEMETRY_MAGIC || Header.Version != LEVIATHAN_TELEMETRY_VERSION)
+	{
+		UE_LOG(LogLeviathan, Error, TEXT("%s is not a version %d telemetry file"), *Filename,
+			LEVIATHAN_TELEMETRY_VERSION);
+		return 1;
+	}
+
+	TArray<FLeviathanTelemetryEvent> Events;
+	while(Reader->Tell() < Reader->TotalSize() && !Reader->IsError())
+	{
+		*Reader << Events.AddDefaulted_GetRef();
+	}
+	//A partly written record at the end of the file (crash during flush) is dropped.
+	if(Reader->IsError() && Events.Num() > 0)
+	{
+		Events.Pop();
+	}
+
+	int32 Counts[4] = {};
+	double TotalFlightTime = 0.0;
+	double TotalReturnDuration = 0.0;
+	double TotalDistance = 0.0;
+	FString Csv = TEXT("Time,AxeId,Event,Surface,SpinCount,OriginX,OriginY,OriginZ,DirX,DirY,DirZ,FlightTime,")
+		TEXT("DistanceFromCharacter,ReturnDuration\n");
+
+	for(const FLeviathanTelemetryEvent& Event : Events)
+	{
+		const int32 TypeIndex = FMath::Clamp(int32(Event.Type), 0, 3);
+		Counts[TypeIndex]++;
+		if(Event.Type == ELeviathanAxeTraceEvent::Lodge)
+		{
+			TotalFlightTime += Event.FlightTime;
+		}
+		else if(Event.Type == ELeviathanAxeTraceEvent::Recall)
+		{
+			TotalDistance += Event.DistanceFromCharacter;
+		}
+		else if(Event.Type == ELeviathanAxeTraceEvent::Catch)
+		{
+			TotalReturnDuration += Event.ReturnDuration;
+		}
+
+		Csv += FString::Printf(TEXT("%.4f,%u,%s,%u,%u,%.2f,%.2f,%.2f,%.4f,%.4f,%.4f,%.4f,%.2f,%.4f\n"), Event.Time,
+			Event.AxeId, GetEventName(Event.Type), Event.Surface, Event.SpinCount, Event.ThrowOrigin.X,
+			Event.ThrowOrigin.Y, Event.ThrowOrigin.Z, Event.ThrowDirection.X, Event.ThrowDirection.Y,
+			Event.ThrowDirection.Z, Event.FlightTime, Event.DistanceFromCharacter, Event.ReturnDuration);
+	}
+
+	UE_LOG(LogLeviathan, Display, TEXT("%s: %d events"), *Filename, Events.Num());
+	UE_LOG(LogLeviathan, Display, TEXT("  Throws %d, Lodges %d, Recalls %d, Catches %d"), Counts[0], Counts[1],
+		Counts[2], Counts[3]);
+	UE_LOG(LogLeviathan, Display, TEXT("  Avg flight time %.3f s, avg recall distance %.1f, avg return %.3f s"),
+		Counts[1] > 0 ? TotalFlightTime / Counts[1] : 0.0, Counts[2] > 0 ? TotalDistance / Counts[2] : 0.0,
+		Counts[3] > 0 ? TotalReturnDuration / Counts[3] : 0.0);
+
+	FString CsvFilename;
+	if(FParse::Value(*Params, TEXT("Csv="), CsvFilename))
+	{
+		if(!FFileHelper::SaveStringToFile(Csv, *CsvFilename))
+		{
+			UE_LOG(LogLeviathan, Error, TEXT("Could not write %s"), *CsvFilename);
+			return 1;
+		}
+		UE_LOG(LogLeviathan, Display, TEXT("Wrote %s"), *CsvFilename);
+	}
+	return 0;
+}
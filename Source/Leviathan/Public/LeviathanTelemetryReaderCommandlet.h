@@ -0,0 +1,23 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "LeviathanTelemetryReaderCommandlet.generated.h"
+
+/**Offline reader for the throw telemetry files.
+ * UE4Editor-Cmd Leviathan.uproject -run=LeviathanTelemetryReader -File=<file.levtel> [-Csv=<out.csv>]
+ * Prints a per event type summary and optionally converts the file to csv.
+ */
+UCLASS()
+class ULeviathanTelemetryReaderCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	ULeviathanTelemetryReaderCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,136 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanThrowable.h"
+
+#include "Leviathan.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/KismetMathLibrary.h"
+#include "Math/RandomStream.h"
+#include "Misc/Parse.h"
+
+#if !UE_BUILD_SHIPPING
+namespace LeviathanThrowableBench
+{
+	//The lodge and return maths as ALeviathanAxe did them before the policies, kept only to compare against.
+	static float LegacyImpactPitchOffset(const FVector& ImpactNormal)
+	{
+		const float InclinedSurfaceOffset = FMath::FRandRange(-30.0f, -55.0f);
+		const float FlatSurfaceOffset = FMath::FRandRange(-5.0f, -25.0f);
+		const FRotator Rotator = UKismetMathLibrary::MakeRotationFromAxes(ImpactNormal, FVector(0), FVector(0));
+		if(Rotator.Pitch > 0.0f)
+		{
+			return FlatSurfaceOffset - Rotator.Pitch;
+		}
+		return InclinedSurfaceOffset - Rotator.Pitch;
+	}
+
+	static float LegacyImpactZOffset(const FVector& ImpactNormal)
+	{
+		const FRotator Rotator = UKismetMathLibrary::MakeRotationFromAxes(ImpactNormal, FVector(0), FVector(0));
+		if(Rotator.Pitch > 0.0f)
+		{
+			return ((90.f - Rotator.Pitch) / 90.f) * 10.f;
+		}
+		return 10.f;
+	}
+
+	static FVector LegacyReturnLocation(const FVector& InitialLocation, const FVector& SocketLocation,
+		const FVector& CameraRight, float Distance, float CurveScalar, float Curvature, float Alpha)
+	{
+		const float CurveLocation = (Distance / CurveScalar) * Curvature;
+		const FVector CalculatedCurveAxeLocation = SocketLocation + CameraRight * CurveLocation;
+		return FMath::Lerp(InitialLocation, CalculatedCurveAxeLocation, Alpha);
+	}
+
+	struct FSample
+	{
+		FVector Normal;
+		FVector Initial;
+		FVector Socket;
+		FVector Right;
+		float Distance;
+		float Alpha;
+	};
+
+	//Runs Iterations lodges and returns over Samples, returns milliseconds. Sink keeps the results alive.
+	template<typename FunctionType>
+	static double Time(const TArray<FSample>& Samples, int32 Iterations, float& Sink, FunctionType&& Function)
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		float Sum = 0.f;
+		for(int32 Iteration = 0; Iteration < Iterations; Iteration++)
+		{
+			Sum += Function(Samples[Iteration & (Samples.Num() - 1)]);
+		}
+		Sink += Sum;
+		return FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	}
+}
+
+/**Leviathan.Throwable.Bench [Iterations=1000000]
+ * Times the lodge (pitch offset and height) and return curve of the axe through FLeviathanAxeThrowable against the
+ * previous branching Kismet based code, and checks they agree.*/
+static FAutoConsoleCommandWithArgs ThrowableBenchCommand(
+	TEXT("Leviathan.Throwable.Bench"),
+	TEXT("Compares the policy specialized axe lodge/return maths with the previous code. Iterations=1000000."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		using namespace LeviathanThrowableBench;
+		int32 Iterations = 1000000;
+		for(const FString& Arg : Args)
+		{
+			FParse::Value(*Arg, TEXT("Iterations="), Iterations);
+		}
+		Iterations = FMath::Max(Iterations, 1);
+
+		//Power of two so the sample index is a mask.
+		FRandomStream Random(4321);
+		TArray<FSample> Samples;
+		Samples.SetNum(4096);
+		for(FSample& Sample : Samples)
+		{
+			Sample.Normal = Random.GetUnitVector();
+			Sample.Initial = Random.GetUnitVector() * Random.FRandRange(100.f, 3000.f);
+			Sample.Socket = Random.GetUnitVector() * 100.f;
+			Sample.Right = Random.GetUnitVector();
+			Sample.Distance = Random.FRandRange(100.f, 3000.f);
+			Sample.Alpha = Random.GetFraction();
+		}
+
+		const float CurveScalar = 1.f;
+		const float Curvature = 0.3f;
+		float Sink = 0.f;
+		const double LegacyMs = Time(Samples, Iterations, Sink, [CurveScalar, Curvature](const FSample& Sample)
+		{
+			return LegacyImpactPitchOffset(Sample.Normal) + LegacyImpactZOffset(Sample.Normal)
+				+ LegacyReturnLocation(Sample.Initial, Sample.Socket, Sample.Right, Sample.Distance, CurveScalar,
+					Curvature, Sample.Alpha).Z;
+		});
+		const double PolicyMs = Time(Samples, Iterations, Sink, [CurveScalar, Curvature](const FSample& Sample)
+		{
+			return FLeviathanAxeThrowable::ImpactPitchOffset(Sample.Normal, FMath::FRand())
+				+ FLeviathanAxeThrowable::ImpactZOffset(Sample.Normal)
+				+ FLeviathanAxeThrowable::ReturnLocation(Sample.Initial, Sample.Socket, Sample.Right, Sample.Distance,
+					CurveScalar, Curvature, Sample.Alpha).Z;
+		});
+
+		//The random parts differ, compare the deterministic ones.
+		float WorstZOffset = 0.f;
+		float WorstReturn = 0.f;
+		for(const FSample& Sample : Samples)
+		{
+			WorstZOffset = FMath::Max(WorstZOffset,
+				FMath::Abs(LegacyImpactZOffset(Sample.Normal) - FLeviathanAxeThrowable::ImpactZOffset(Sample.Normal)));
+			WorstReturn = FMath::Max(WorstReturn, FVector::Dist(
+				LegacyReturnLocation(Sample.Initial, Sample.Socket, Sample.Right, Sample.Distance, CurveScalar, Curvature,
+					Sample.Alpha),
+				FLeviathanAxeThrowable::ReturnLocation(Sample.Initial, Sample.Socket, Sample.Right, Sample.Distance,
+					CurveScalar, Curvature, Sample.Alpha)));
+		}
+
+		UE_LOG(LogLeviathan, Display, TEXT("Throwable bench, %d iterations: previous %.3f ms (%.2f ns each), ")
+			TEXT("FLeviathanAxeThrowable %.3f ms (%.2f ns each), %.2fx. Worst difference: Z offset %.4f, return %.4f ")
+			TEXT("(sink %.1f)"), Iterations, LegacyMs, LegacyMs * 1e6 / Iterations, PolicyMs, PolicyMs * 1e6 / Iterations,
+			LegacyMs / FMath::Max(PolicyMs, 1e-6), WorstZOffset, WorstReturn, Sink);
+	}));
+#endif
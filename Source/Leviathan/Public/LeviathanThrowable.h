@@ -0,0 +1,116 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Policies of TLeviathanThrowableCore. Each one is a set of static FORCEINLINE functions and constants, a weapon picks
+//one of each at compile time so its hot path has no runtime switch on the weapon kind.
+
+//Spin model: how SpinAxe turns the timeline value (one full turn per 1.0) into the CenterPoint rotation.
+struct FLeviathanAxeSpin
+{
+	//End over end, around the pitch axis.
+	static FORCEINLINE FRotator Rotation(float RotateScalar) { return FRotator(RotateScalar * -360.f, 0.f, 0.f); }
+};
+
+struct FLeviathanShieldSpin
+{
+	//Flat like a disc, around the yaw axis.
+	static FORCEINLINE FRotator Rotation(float RotateScalar) { return FRotator(0.f, RotateScalar * -360.f, 0.f); }
+};
+
+/**Lodge model: how the weapon sits in the surface it hit. NormalPitch is the pitch of the impact normal in degrees,
+ * positive on floors ("flat") and zero or negative on walls and ceilings ("inclined").*/
+struct FLeviathanBladeLodge
+{
+	//Random pitch of the lodged blade, -5..-25 degrees into floors and -30..-55 into walls. Random is in [0, 1).
+	static FORCEINLINE float ImpactPitchOffset(float NormalPitch, float Random)
+	{
+		const float Flat = NormalPitch > 0.f ? 1.f : 0.f;
+		const float Offset = FMath::Lerp(FMath::Lerp(-30.f, -55.f, Random), FMath::Lerp(-5.f, -25.f, Random), Flat);
+		return Offset - NormalPitch;
+	}
+	//Raise above the impact point, less on floors so the blade sinks in.
+	static FORCEINLINE float ImpactZOffset(float NormalPitch)
+	{
+		return FMath::Min((90.f - NormalPitch) / 90.f * 10.f, 10.f);
+	}
+};
+
+struct FLeviathanEdgeLodge
+{
+	//Rim first, square to the surface, no random tilt.
+	static FORCEINLINE float ImpactPitchOffset(float NormalPitch, float Random) { return -NormalPitch; }
+	static FORCEINLINE float ImpactZOffset(float NormalPitch) { return 0.f; }
+};
+
+//Return model: the path back to the hand and what happens when recalled.
+struct FLeviathanCurvedReturn
+{
+	//Lodged weapons wiggle loose before flying back.
+	static constexpr bool bWiggleWhenLodged = true;
+	//Raise of a weapon recalled mid-flight.
+	static constexpr float LaunchedZOffset = 10.f;
+
+	//Sideways offset (along the camera right) of the path, Curvature comes from the return timeline.
+	static FORCEINLINE float CurveOffset(float Distance, float CurveScalar, float Curvature)
+	{
+		return Distance / CurveScalar * Curvature;
+	}
+};
+
+struct FLeviathanStraightReturn
+{
+	static constexpr bool bWiggleWhenLodged = false;
+	static constexpr float LaunchedZOffset = 0.f;
+
+	static FORCEINLINE float CurveOffset(float Distance, float CurveScalar, float Curvature) { return 0.f; }
+};
+
+/**Weapon independent throw maths, specialized by the spin, lodge and return policies.
+ * ALeviathanAxe keeps its UFUNCTIONs and forwards to FLeviathanAxeThrowable, another throwable (a shield) picks its own
+ * policies and gets its own fully inlined path.
+ */
+template<typename SpinPolicy, typename LodgePolicy, typename ReturnPolicy>
+struct TLeviathanThrowableCore
+{
+	using FSpin = SpinPolicy;
+	using FLodge = LodgePolicy;
+	using FReturn = ReturnPolicy;
+
+	static FORCEINLINE FRotator SpinRotation(float RotateScalar)
+	{
+		return SpinPolicy::Rotation(RotateScalar);
+	}
+
+	//Pitch of MakeRotationFromAxes(ImpactNormal, 0, 0), without building the matrix.
+	static FORCEINLINE float NormalPitch(const FVector& ImpactNormal)
+	{
+		return FMath::RadiansToDegrees(FMath::Atan2(ImpactNormal.Z,
+			FMath::Sqrt(ImpactNormal.X * ImpactNormal.X + ImpactNormal.Y * ImpactNormal.Y)));
+	}
+
+	static FORCEINLINE float ImpactPitchOffset(const FVector& ImpactNormal, float Random)
+	{
+		return LodgePolicy::ImpactPitchOffset(NormalPitch(ImpactNormal), Random);
+	}
+
+	static FORCEINLINE float ImpactZOffset(const FVector& ImpactNormal)
+	{
+		return LodgePolicy::ImpactZOffset(NormalPitch(ImpactNormal));
+	}
+
+	//Where the weapon is on the way back at Alpha (0 where it was recalled, 1 at the hand socket).
+	static FORCEINLINE FVector ReturnLocation(const FVector& InitialLocation, const FVector& SocketLocation,
+		const FVector& CameraRight, float Distance, float CurveScalar, float Curvature, float Alpha)
+	{
+		const FVector CurvedTarget = SocketLocation
+			+ CameraRight * ReturnPolicy::CurveOffset(Distance, CurveScalar, Curvature);
+		return FMath::Lerp(InitialLocation, CurvedTarget, Alpha);
+	}
+};
+
+using FLeviathanAxeThrowable = TLeviathanThrowableCore<FLeviathanAxeSpin, FLeviathanBladeLodge, FLeviathanCurvedReturn>;
+using FLeviathanShieldThrowable = TLeviathanThrowableCore<FLeviathanShieldSpin, FLeviathanEdgeLodge,
+	FLeviathanStraightReturn>;
@@ -0,0 +1,30 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanTrace.h"
+
+#if LEVIATHAN_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_DEFINE(LeviathanChannel)
+
+UE_TRACE_EVENT_BEGIN(Leviathan, AxeEvent)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, AxeId)
+	UE_TRACE_EVENT_FIELD(float, ElapsedMs)
+	UE_TRACE_EVENT_FIELD(float, Distance)
+	UE_TRACE_EVENT_FIELD(uint8, Event)
+	UE_TRACE_EVENT_FIELD(uint8, SurfaceType)
+UE_TRACE_EVENT_END()
+
+void FLeviathanTrace::OutputAxeEvent(ELeviathanAxeTraceEvent Event, const UObject* Axe, float ElapsedMs, float Distance,
+	uint8 SurfaceType)
+{
+	UE_TRACE_LOG(Leviathan, AxeEvent, LeviathanChannel)
+		<< AxeEvent.Cycle(FPlatformTime::Cycles64())
+		<< AxeEvent.AxeId(Axe ? Axe->GetUniqueID() : 0)
+		<< AxeEvent.ElapsedMs(ElapsedMs)
+		<< AxeEvent.Distance(Distance)
+		<< AxeEvent.Event(uint8(Event))
+		<< AxeEvent.SurfaceType(SurfaceType);
+}
+
+#endif
@@ -0,0 +1,41 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Trace.h"
+
+//The trace channel is compiled out in Shipping, when it is off at runtime UE_TRACE_LOG does nothing.
+#define LEVIATHAN_TRACE_ENABLED (UE_TRACE_ENABLED && !UE_BUILD_SHIPPING)
+
+//What happened to the axe, stored in the trace as a byte.
+enum class ELeviathanAxeTraceEvent : uint8
+{
+	Throw,
+	Lodge,
+	Recall,
+	Catch
+};
+
+#if LEVIATHAN_TRACE_ENABLED
+
+//Enable with -trace=Leviathan (or Trace.Enable Leviathan) to see the axe events in Unreal Insights.
+UE_TRACE_CHANNEL_EXTERN(LeviathanChannel, LEVIATHAN_API)
+
+struct LEVIATHAN_API FLeviathanTrace
+{
+	/**@param ElapsedMs		Time since the previous phase (flight time for Lodge, return time for Catch)
+	 * @param Distance		Distance travelled or distance to the character, depending on the event
+	 * @param SurfaceType	EPhysicalSurface the axe hit, SurfaceType_Default when it does not apply*/
+	static void OutputAxeEvent(ELeviathanAxeTraceEvent Event, const UObject* Axe, float ElapsedMs, float Distance,
+		uint8 SurfaceType);
+};
+
+#define TRACE_LEVIATHAN_AXE_EVENT(Event, Axe, ElapsedMs, Distance, SurfaceType) \
+	FLeviathanTrace::OutputAxeEvent(ELeviathanAxeTraceEvent::Event, Axe, ElapsedMs, Distance, SurfaceType)
+
+#else
+
+#define TRACE_LEVIATHAN_AXE_EVENT(Event, Axe, ElapsedMs, Distance, SurfaceType)
+
+#endif
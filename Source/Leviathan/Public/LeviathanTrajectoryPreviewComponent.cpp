@@ -0,0 +1,214 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanTrajectoryPreviewComponent.h"
+
+#include "Leviathan.h"
+#include "LeviathanAxe.h"
+#include "LeviathanCharacter.h"
+#include "Camera/CameraComponent.h"
+#include "Components/ChildActorComponent.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_CYCLE_STAT(TEXT("TrajectoryPreview Tick"), STAT_TrajectoryPreviewTick, STATGROUP_Leviathan);
+DECLARE_CYCLE_STAT(TEXT("TrajectoryPreview Simulate"), STAT_TrajectoryPreviewSimulate, STATGROUP_Leviathan);
+
+//Async trace user data: low 16 bits are the segment, high 16 bits the prediction it belongs to.
+static uint32 PackTraceUserData(uint32 PredictionId, int32 Segment)
+{
+	return ((PredictionId & 0xFFFF) << 16) | (uint32(Segment) & 0xFFFF);
+}
+
+ULeviathanTrajectoryPreviewComponent::ULeviathanTrajectoryPreviewComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	//Only ticks while aiming.
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+void ULeviathanTrajectoryPreviewComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	TraceDelegate.BindUObject(this, &ULeviathanTrajectoryPreviewComponent::OnTraceDone);
+}
+
+void ULeviathanTrajectoryPreviewComponent::SetPreviewActive(bool bActive)
+{
+	SetComponentTickEnabled(bActive);
+	if(!bActive)
+	{
+		//Forget everything, results still in flight are dropped by the id check.
+		bPredicting = false;
+		bHasPrediction = false;
+		bHasCameraPose = false;
+		PredictedPath.Reset();
+		PredictionId++;
+	}
+}
+
+ALeviathanAxe* ULeviathanTrajectoryPreviewComponent::GetAxe() const
+{
+	const ALeviathanCharacter* Character = Cast<ALeviathanCharacter>(GetOwner());
+	return Character ? Cast<ALeviathanAxe>(Character->LeviathanAxeChildActorComponent->GetChildActor()) : nullptr;
+}
+
+void ULeviathanTrajectoryPreviewComponent::TickComponent(float DeltaTime, ELevelTick TickType,
+	FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TrajectoryPreviewTick);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const ALeviathanCharacter* Character = Cast<ALeviathanCharacter>(GetOwner());
+	if(!Character)
+	{
+		return;
+	}
+
+	if(!bPredicting)
+	{
+		const FVector CameraLocation = Character->FollowCamera->GetComponentLocation();
+		const FRotator CameraRotation = Character->FollowCamera->GetComponentRotation();
+		const bool bCameraMoved = !bHasCameraPose
+			|| !CameraLocation.Equals(LastCameraLocation, ReuseLocationThreshold)
+			|| !CameraRotation.Equals(LastCameraRotation, ReuseAngleThresholdDegrees);
+		if(!bCameraMoved)
+		{
+			//Reuse the last prediction.
+			return;
+		}
+		StartPrediction(CameraLocation, CameraRotation);
+	}
+	IssueTraces();
+}
+
+void ULeviathanTrajectoryPreviewComponent::SimulateFlight(const ALeviathanAxe& Axe, const FVector& CameraLocation,
+	const FRotator& CameraRotation, float GravityZ, float Step, float MaxTime, TArray<FVector>& OutPoints)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TrajectoryPreviewSimulate);
+
+	//Same start as ALeviathanAxe::MoveAxeToStartPosition and ProjectAxe.
+	const FVector Direction = CameraRotation.Vector();
+	FVector Location = CameraLocation + FVector(Axe.SpinAxeAxisOffset, 0.f, 0.f) + Direction * Axe.AxeThrowScalar
+		- Axe.CenterPoint->GetRelativeLocation();
+	FVector Velocity = Direction * Axe.ThrowSpeed;
+	const FVector TraceOffset(0.f, 0.f, Axe.AxeTraceZOffset);
+	const FLeviathanAxeFlightModel FlightModel = Axe.GetFlightModel(GravityZ);
+
+	const int32 NumSteps = FMath::Max(FMath::CeilToInt(MaxTime / Step), 1);
+	OutPoints.Reset(NumSteps + 1);
+	OutPoints.Add(Location + TraceOffset);
+
+	float Time = 0.f;
+	for(int32 StepIndex = 0; StepIndex < NumSteps; StepIndex++)
+	{
+		FlightModel.Step(Location, Velocity, Time, Step);
+		OutPoints.Add(Location + TraceOffset);
+	}
+}
+
+void ULeviathanTrajectoryPreviewComponent::StartPrediction(const FVector& CameraLocation, const FRotator& CameraRotation)
+{
+	const ALeviathanAxe* Axe = GetAxe();
+	if(!Axe)
+	{
+		return;
+	}
+	LastCameraLocation = CameraLocation;
+	LastCameraRotation = CameraRotation;
+	bHasCameraPose = true;
+
+	SimulateFlight(*Axe, CameraLocation, CameraRotation, GetWorld()->GetGravityZ(), SimulationStep, MaxFlightTime,
+		WorkingPath);
+	const int32 NumSegments = WorkingPath.Num() - 1;
+	SegmentStates.Init(ESegmentState::NotIssued, NumSegments);
+	SegmentHits.SetNum(NumSegments);
+	NextSegment = 0;
+	PredictionId++;
+	bPredicting = true;
+}
+
+void ULeviathanTrajectoryPreviewComponent::IssueTraces()
+{
+	if(!bPredicting)
+	{
+		return;
+	}
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(LeviathanTrajectoryPreview), false, GetOwner());
+	Params.bReturnPhysicalMaterial = true;
+	if(const ALeviathanAxe* Axe = GetAxe())
+	{
+		Params.AddIgnoredActor(Axe);
+	}
+
+	int32 Issued = 0;
+	while(Issued < TracesPerFrame && NextSegment < SegmentStates.Num())
+	{
+		GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, WorkingPath[NextSegment],
+			WorkingPath[NextSegment + 1], ECC_Visibility, Params, FCollisionResponseParams::DefaultResponseParam,
+			&TraceDelegate, PackTraceUserData(PredictionId, NextSegment));
+		SegmentStates[NextSegment] = ESegmentState::Pending;
+		NextSegment++;
+		Issued++;
+	}
+}
+
+void ULeviathanTrajectoryPreviewComponent::OnTraceDone(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	if(!bPredicting || (Datum.UserData >> 16) != (PredictionId & 0xFFFF))
+	{
+		return;
+	}
+	const int32 Segment = Datum.UserData & 0xFFFF;
+	if(!SegmentStates.IsValidIndex(Segment))
+	{
+		return;
+	}
+
+	const FHitResult* Hit = Datum.OutHits.FindByPredicate([](const FHitResult& Result) { return Result.bBlockingHit; });
+	if(Hit)
+	{
+		SegmentStates[Segment] = ESegmentState::Hit;
+		SegmentHits[Segment] = *Hit;
+		//Nothing after the first hit matters, stop issuing.
+		NextSegment = FMath::Min(NextSegment, Segment + 1);
+	}
+	else
+	{
+		SegmentStates[Segment] = ESegmentState::Miss;
+	}
+	ResolvePrediction();
+}
+
+void ULeviathanTrajectoryPreviewComponent::ResolvePrediction()
+{
+	//The prediction is done once every segment before the first hit is known to be a miss.
+	for(int32 Segment = 0; Segment < SegmentStates.Num(); Segment++)
+	{
+		switch(SegmentStates[Segment])
+		{
+			case ESegmentState::Miss:
+				continue;
+			case ESegmentState::Hit:
+			{
+				const FHitResult& Hit = SegmentHits[Segment];
+				bHasPrediction = true;
+				PredictedLodgeLocation = Hit.ImpactPoint;
+				PredictedLodgeNormal = Hit.ImpactNormal;
+				PredictedSurface = UGameplayStatics::GetSurfaceType(Hit);
+				PredictedPath.Reset(Segment + 2);
+				PredictedPath.Append(WorkingPath.GetData(), Segment + 1);
+				PredictedPath.Add(Hit.ImpactPoint);
+				bPredicting = false;
+				return;
+			}
+			default:
+				//Still waiting on this one.
+				return;
+		}
+	}
+	//Flew for MaxFlightTime without hitting anything.
+	bHasPrediction = false;
+	PredictedSurface = SurfaceType_Default;
+	PredictedPath = WorkingPath;
+	bPredicting = false;
+}
@@ -0,0 +1,92 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Engine/EngineTypes.h"
+#include "WorldCollision.h"
+
+#include "LeviathanTrajectoryPreviewComponent.generated.h"
+
+/**Predicts where the axe will lodge while the character aims, using the same flight model as ALeviathanAxe
+ * (ThrowSpeed, zero gravity phase, then the gravity ramp of ChangeGravityAndHit).
+ * The path is swept with async line traces, at most TracesPerFrame per frame, so a full prediction is spread over a
+ * few frames. While a new prediction is in flight the last finished one stays valid, and no new prediction is started
+ * while the camera stays within the reuse thresholds.
+ */
+UCLASS(ClassGroup = (Axe), meta = (BlueprintSpawnableComponent))
+class LEVIATHAN_API ULeviathanTrajectoryPreviewComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	ULeviathanTrajectoryPreviewComponent();
+
+	//Turned on and off by ALeviathanCharacter::Aim.
+	UFUNCTION(BlueprintCallable, Category = AxeAim)
+	void SetPreviewActive(bool bActive);
+
+	//True once a prediction finished and hit something.
+	UPROPERTY(BlueprintReadOnly, Category = AxeAim)
+	bool bHasPrediction = false;
+	UPROPERTY(BlueprintReadOnly, Category = AxeAim)
+	FVector PredictedLodgeLocation = FVector::ZeroVector;
+	UPROPERTY(BlueprintReadOnly, Category = AxeAim)
+	FVector PredictedLodgeNormal = FVector::UpVector;
+	UPROPERTY(BlueprintReadOnly, Category = AxeAim)
+	TEnumAsByte<EPhysicalSurface> PredictedSurface = SurfaceType_Default;
+	//Points of the last finished prediction, up to the lodge point. For drawing the arc.
+	UPROPERTY(BlueprintReadOnly, Category = AxeAim)
+	TArray<FVector> PredictedPath;
+
+	//Maximum async traces issued per frame.
+	UPROPERTY(EditAnywhere, Category = AxeAim, meta = (ClampMin = "1"))
+	int32 TracesPerFrame = 8;
+	//Time step of the flight simulation, one trace per step.
+	UPROPERTY(EditAnywhere, Category = AxeAim, meta = (ClampMin = "0.01"))
+	float SimulationStep = 0.05f;
+	//How long a flight is simulated before giving up.
+	UPROPERTY(EditAnywhere, Category = AxeAim)
+	float MaxFlightTime = 3.f;
+	//Camera moves under these thresholds keep the previous prediction.
+	UPROPERTY(EditAnywhere, Category = AxeAim)
+	float ReuseLocationThreshold = 2.f;
+	UPROPERTY(EditAnywhere, Category = AxeAim)
+	float ReuseAngleThresholdDegrees = 0.25f;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
+		FActorComponentTickFunction* ThisTickFunction) override;
+
+	/**Simulates the flight of the axe thrown from the given camera pose.
+	 * @param OutPoints Trace space points (the axe location raised by AxeTraceZOffset), one per SimulationStep*/
+	static void SimulateFlight(const class ALeviathanAxe& Axe, const FVector& CameraLocation,
+		const FRotator& CameraRotation, float GravityZ, float Step, float MaxTime, TArray<FVector>& OutPoints);
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	enum class ESegmentState : uint8 { NotIssued, Pending, Miss, Hit };
+
+	void StartPrediction(const FVector& CameraLocation, const FRotator& CameraRotation);
+	void IssueTraces();
+	void ResolvePrediction();
+	void OnTraceDone(const FTraceHandle& Handle, FTraceDatum& Datum);
+	class ALeviathanAxe* GetAxe() const;
+
+	FTraceDelegate TraceDelegate;
+
+	//Prediction being worked on.
+	TArray<FVector> WorkingPath;
+	TArray<ESegmentState> SegmentStates;
+	TArray<FHitResult> SegmentHits;
+	int32 NextSegment = 0;
+	bool bPredicting = false;
+	//Bumped on every new prediction so late results from the previous one are ignored.
+	uint32 PredictionId = 0;
+
+	FVector LastCameraLocation = FVector::ZeroVector;
+	FRotator LastCameraRotation = FRotator::ZeroRotator;
+	bool bHasCameraPose = false;
+};
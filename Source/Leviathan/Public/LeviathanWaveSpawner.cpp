@@ -0,0 +1,293 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeviathanWaveSpawner.h"
+
+#include "Leviathan.h"
+#include "LeviathanPerfBudget.h"
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PawnMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/Parse.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spawner Tick"), STAT_SpawnerTick, STATGROUP_Leviathan);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawner Spawned This Frame"), STAT_SpawnerSpawnedThisFrame, STATGROUP_Leviathan);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Spawner Pending"), STAT_SpawnerPending, STATGROUP_Leviathan);
+
+bool ULeviathanWaveSpawnerSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void ULeviathanWaveSpawnerSubsystem::Deinitialize()
+{
+	for(TPair<FSoftObjectPath, TSharedPtr<FStreamableHandle>>& Handle : ClassHandles)
+	{
+		if(Handle.Value.IsValid())
+		{
+			Handle.Value->CancelHandle();
+		}
+	}
+	ClassHandles.Reset();
+	SET_DWORD_STAT(STAT_SpawnerPending, 0);
+	Pending.Reset();
+	Waves.Reset();
+	Pools.Reset();
+	Super::Deinitialize();
+}
+
+ETickableTickType ULeviathanWaveSpawnerSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId ULeviathanWaveSpawnerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULeviathanWaveSpawnerSubsystem, STATGROUP_Tickables);
+}
+
+bool ULeviathanWaveSpawnerSubsystem::RequestClass(const TSoftClassPtr<AActor>& ActorClass)
+{
+	if(ActorClass.IsNull())
+	{
+		return false;
+	}
+	const FSoftObjectPath& Path = ActorClass.ToSoftObjectPath();
+	if(!ClassHandles.Contains(Path))
+	{
+		//The handle keeps the class loaded for as long as the world lives, later waves don't wait on it again.
+		ClassHandles.Add(Path, Streamable.RequestAsyncLoad(Path, FStreamableDelegate(),
+			FStreamableManager::AsyncLoadHighPriority));
+	}
+	return true;
+}
+
+int32 ULeviathanWaveSpawnerSubsystem::QueueWave(TSoftClassPtr<AActor> ActorClass, const TArray<FTransform>& Transforms)
+{
+	if(Transforms.Num() == 0 || !RequestClass(ActorClass))
+	{
+		return INDEX_NONE;
+	}
+	const int32 WaveId = NextWaveId++;
+	FWaveProgress& Wave = Waves.Add(WaveId);
+	Wave.Remaining = Transforms.Num();
+	Wave.QueuedSeconds = FPlatformTime::Seconds();
+
+	Pending.Reserve(Pending.Num() + Transforms.Num());
+	for(const FTransform& Transform : Transforms)
+	{
+		Pending.Add({ ActorClass, Transform, WaveId });
+	}
+	INC_DWORD_STAT_BY(STAT_SpawnerPending, Transforms.Num());
+	return WaveId;
+}
+
+void ULeviathanWaveSpawnerSubsystem::Prewarm(TSoftClassPtr<AActor> ActorClass, int32 Count)
+{
+	if(Count <= 0 || !RequestClass(ActorClass))
+	{
+		return;
+	}
+	for(int32 Index = 0; Index < Count; Index++)
+	{
+		Pending.Add({ ActorClass, FTransform::Identity, INDEX_NONE });
+	}
+	INC_DWORD_STAT_BY(STAT_SpawnerPending, Count);
+}
+
+void ULeviathanWaveSpawnerSubsystem::ReleaseActor(AActor* Actor)
+{
+	if(!Actor || Actor->IsPendingKill())
+	{
+		return;
+	}
+	DeactivateActor(Actor);
+	Pools.FindOrAdd(Actor->GetClass()).Free.AddUnique(Actor);
+}
+
+void ULeviathanWaveSpawnerSubsystem::DeactivateActor(AActor* Actor)
+{
+	Actor->SetActorHiddenInGame(true);
+	Actor->SetActorEnableCollision(false);
+	Actor->SetActorTickEnabled(false);
+	if(APawn* Pawn = Cast<APawn>(Actor))
+	{
+		if(UPawnMovementComponent* Movement = Pawn->GetMovementComponent())
+		{
+			Movement->StopMovementImmediately();
+			Movement->Deactivate();
+		}
+		const AAIController* AIController = Cast<AAIController>(Pawn->GetController());
+		if(AIController && AIController->GetBrainComponent())
+		{
+			AIController->GetBrainComponent()->StopLogic(TEXT("Pooled"));
+		}
+	}
+}
+
+void ULeviathanWaveSpawnerSubsystem::ActivateActor(AActor* Actor, const FTransform& Transform)
+{
+	Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+	Actor->SetActorHiddenInGame(false);
+	Actor->SetActorEnableCollision(true);
+	Actor->SetActorTickEnabled(true);
+	if(APawn* Pawn = Cast<APawn>(Actor))
+	{
+		if(UPawnMovementComponent* Movement = Pawn->GetMovementComponent())
+		{
+			Movement->Activate();
+		}
+		const AAIController* AIController = Cast<AAIController>(Pawn->GetController());
+		if(AIController && AIController->GetBrainComponent())
+		{
+			AIController->GetBrainComponent()->RestartLogic();
+		}
+	}
+}
+
+AActor* ULeviathanWaveSpawnerSubsystem::AcquireActor(UClass* Class, const FTransform& Transform)
+{
+	if(FLeviathanSpawnPool* Pool = Pools.Find(Class))
+	{
+		while(Pool->Free.Num() > 0)
+		{
+			AActor* Actor = Pool->Free.Pop(false);
+			if(Actor && !Actor->IsPendingKill())
+			{
+				ActivateActor(Actor, Transform);
+				return Actor;
+			}
+		}
+	}
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	return GetWorld()->SpawnActor<AActor>(Class, Transform, SpawnParameters);
+}
+
+void ULeviathanWaveSpawnerSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpawnerTick);
+	LEVIATHAN_PERF_SCOPE(SpawnFrame);
+
+	const double BudgetMs = GetDefault<ULeviathanPerfSettings>()->SpawnBudgetMsPerFrame;
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	auto ElapsedMs = [StartCycles]()
+	{
+		return FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	};
+
+	TSet<int32> WavesThisFrame;
+	int32 Spawned = 0;
+	int32 Consumed = 0;
+	int32 Write = 0;
+	for(int32 Read = 0; Read < Pending.Num(); Read++)
+	{
+		//Spawn is only used until the actor is acquired. Its BeginPlay and OnActorSpawned can queue more spawns and
+		//reallocate Pending, so what is needed after is copied first.
+		FPendingSpawn& Spawn = Pending[Read];
+		const int32 WaveId = Spawn.WaveId;
+		//Always spawn at least one per frame so a single expensive class still makes progress.
+		const bool bOverBudget = Spawned > 0 && ElapsedMs() >= BudgetMs;
+		UClass* Class = bOverBudget ? nullptr : Spawn.Class.Get();
+		if(!Class)
+		{
+			const TSharedPtr<FStreamableHandle>* Handle = ClassHandles.Find(Spawn.Class.ToSoftObjectPath());
+			const bool bFailed = !bOverBudget && (!Handle || !Handle->IsValid() || (*Handle)->HasLoadCompleted()
+				|| (*Handle)->WasCanceled());
+			if(!bFailed)
+			{
+				//Still loading or out of time, keep it queued in order.
+				if(Write != Read)
+				{
+					Pending[Write] = MoveTemp(Spawn);
+				}
+				Write++;
+				continue;
+			}
+			UE_LOG(LogLeviathan, Warning, TEXT("Wave spawner could not load %s"), *Spawn.Class.ToString());
+		}
+		else
+		{
+			const FTransform Transform = Spawn.Transform;
+			AActor* Actor = AcquireActor(Class, Transform);
+			Spawned++;
+			if(Actor && WaveId == INDEX_NONE)
+			{
+				ReleaseActor(Actor);
+			}
+			else if(Actor)
+			{
+				OnActorSpawned.Broadcast(WaveId, Actor);
+			}
+		}
+
+		Consumed++;
+		if(FWaveProgress* Wave = Waves.Find(WaveId))
+		{
+			Wave->Remaining--;
+			WavesThisFrame.Add(WaveId);
+		}
+	}
+	Pending.SetNum(Write, false);
+
+	const double FrameMs = ElapsedMs();
+	LastFrameSpawnMs = float(FrameMs);
+	SET_DWORD_STAT(STAT_SpawnerSpawnedThisFrame, Spawned);
+	DEC_DWORD_STAT_BY(STAT_SpawnerPending, Consumed);
+
+	for(const int32 WaveId : WavesThisFrame)
+	{
+		FWaveProgress& Wave = Waves[WaveId];
+		Wave.Frames++;
+		Wave.TotalMs += FrameMs;
+		Wave.MaxMs = FMath::Max(Wave.MaxMs, FrameMs);
+		if(Wave.Remaining <= 0)
+		{
+			UE_LOG(LogLeviathan, Log, TEXT("Wave %d spawned over %d frames in %.2f s, %.3f ms per frame (worst %.3f ms)"),
+				WaveId, Wave.Frames, FPlatformTime::Seconds() - Wave.QueuedSeconds, Wave.TotalMs / Wave.Frames, Wave.MaxMs);
+			Waves.Remove(WaveId);
+			OnWaveComplete.Broadcast(WaveId);
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+/**Leviathan.Spawner.Wave [Class=/Game/AI/AI_Master.AI_Master_C] [Count=20] [Radius=1500]
+ * Queues a wave in a ring around the player, watch stat Leviathan and the log line when it completes.*/
+static FAutoConsoleCommandWithWorldAndArgs SpawnerWaveCommand(
+	TEXT("Leviathan.Spawner.Wave"),
+	TEXT("Queues Count actors of Class in a ring of Radius around the player. Defaults to 20 AI_Master at 1500."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		ULeviathanWaveSpawnerSubsystem* Spawner = World ? World->GetSubsystem<ULeviathanWaveSpawnerSubsystem>() : nullptr;
+		if(!Spawner)
+		{
+			return;
+		}
+		FString ClassPath = TEXT("/Game/AI/AI_Master.AI_Master_C");
+		int32 Count = 20;
+		float Radius = 1500.f;
+		for(const FString& Arg : Args)
+		{
+			FParse::Value(*Arg, TEXT("Class="), ClassPath);
+			FParse::Value(*Arg, TEXT("Count="), Count);
+			FParse::Value(*Arg, TEXT("Radius="), Radius);
+		}
+
+		const APawn* Player = UGameplayStatics::GetPlayerPawn(World, 0);
+		const FVector Center = Player ? Player->GetActorLocation() : FVector::ZeroVector;
+		TArray<FTransform> Transforms;
+		for(int32 Index = 0; Index < Count; Index++)
+		{
+			const float Angle = 2.f * PI * Index / FMath::Max(Count, 1);
+			const FVector Offset(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 0.f);
+			Transforms.Add(FTransform((-Offset).Rotation(), Center + Offset));
+		}
+		const int32 WaveId = Spawner->QueueWave(TSoftClassPtr<AActor>(FSoftObjectPath(ClassPath)), Transforms);
+		UE_LOG(LogLeviathan, Display, TEXT("Queued wave %d: %d x %s"), WaveId, Count, *ClassPath);
+	}));
+#endif
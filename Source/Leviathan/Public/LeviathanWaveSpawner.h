@@ -0,0 +1,107 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+
+#include "LeviathanWaveSpawner.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FLeviathanActorSpawnedSignature, int32, WaveId, AActor*, Actor);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FLeviathanWaveCompleteSignature, int32, WaveId);
+
+//Released actors of one class, ready to be reused.
+USTRUCT()
+struct FLeviathanSpawnPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<AActor*> Free;
+};
+
+/**Spawns waves of actors (AI_Master, props) without hitching. Classes are loaded asynchronously and the actors are
+ * spawned a few per frame, as many as fit in SpawnBudgetMsPerFrame of ULeviathanPerfSettings. Actors given back with
+ * ReleaseActor are hidden and reused by the next wave of the same class instead of being destroyed.
+ * The cost of every frame shows in stat Leviathan and in the perf report as SpawnFrame, and each wave logs its
+ * frame count and worst frame when it completes.
+ */
+UCLASS()
+class LEVIATHAN_API ULeviathanWaveSpawnerSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	/**Queues one actor of ActorClass per transform.
+	 * @return Id passed to OnActorSpawned and OnWaveComplete, INDEX_NONE if nothing was queued*/
+	UFUNCTION(BlueprintCallable, Category = Spawner)
+	int32 QueueWave(TSoftClassPtr<AActor> ActorClass, const TArray<FTransform>& Transforms);
+
+	//Spawns Count hidden actors into the pool of ActorClass, using the same frame budget as the waves.
+	UFUNCTION(BlueprintCallable, Category = Spawner)
+	void Prewarm(TSoftClassPtr<AActor> ActorClass, int32 Count);
+
+	//Hides the actor and keeps it for the next wave of its class. Use instead of DestroyActor.
+	UFUNCTION(BlueprintCallable, Category = Spawner)
+	void ReleaseActor(AActor* Actor);
+
+	UFUNCTION(BlueprintPure, Category = Spawner)
+	int32 GetPendingSpawnCount() const { return Pending.Num(); }
+
+	//Milliseconds spent spawning on the last frame that had something to spawn.
+	UFUNCTION(BlueprintPure, Category = Spawner)
+	float GetLastFrameSpawnMs() const { return LastFrameSpawnMs; }
+
+	UPROPERTY(BlueprintAssignable, Category = Spawner)
+	FLeviathanActorSpawnedSignature OnActorSpawned;
+	UPROPERTY(BlueprintAssignable, Category = Spawner)
+	FLeviathanWaveCompleteSignature OnWaveComplete;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Pending.Num() > 0; }
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+private:
+	struct FPendingSpawn
+	{
+		TSoftClassPtr<AActor> Class;
+		FTransform Transform;
+		//INDEX_NONE for prewarm spawns, they go straight into the pool.
+		int32 WaveId = INDEX_NONE;
+	};
+
+	struct FWaveProgress
+	{
+		int32 Remaining = 0;
+		int32 Frames = 0;
+		double TotalMs = 0.0;
+		double MaxMs = 0.0;
+		double QueuedSeconds = 0.0;
+	};
+
+	//Starts loading the class if needed. False if the class can't be loaded.
+	bool RequestClass(const TSoftClassPtr<AActor>& ActorClass);
+	AActor* AcquireActor(UClass* Class, const FTransform& Transform);
+	static void DeactivateActor(AActor* Actor);
+	static void ActivateActor(AActor* Actor, const FTransform& Transform);
+
+	FStreamableManager Streamable;
+	TMap<FSoftObjectPath, TSharedPtr<FStreamableHandle>> ClassHandles;
+
+	TArray<FPendingSpawn> Pending;
+	TMap<int32, FWaveProgress> Waves;
+	int32 NextWaveId = 0;
+
+	UPROPERTY()
+	TMap<UClass*, FLeviathanSpawnPool> Pools;
+
+	float LastFrameSpawnMs = 0.f;
+};